@@ -34,25 +34,27 @@ static std::atomic<long> sessionIdGenerator(1);
 extern void addSessionToSessionHistory(const std::shared_ptr<ffmpegkit::Session> session);
 
 ffmpegkit::AbstractSession::AbstractSession(const std::list<std::string>& arguments, const ffmpegkit::LogCallback logCallback, const LogRedirectionStrategy logRedirectionStrategy) :
+  AbstractSession(arguments, logCallback, logRedirectionStrategy, ffmpegkit::SchedulingOptions()) {
+}
+
+ffmpegkit::AbstractSession::AbstractSession(const std::list<std::string>& arguments, const ffmpegkit::LogCallback logCallback, const LogRedirectionStrategy logRedirectionStrategy, const ffmpegkit::SchedulingOptions& schedulingOptions) :
   _arguments{std::make_shared<std::list<std::string>>(arguments)},
   _sessionId{sessionIdGenerator++},
   _logCallback{logCallback},
   _createTime{std::chrono::system_clock::now()},
-  _logs{std::make_shared<std::list<std::shared_ptr<ffmpegkit::Log>>>()},
+  _schedulingOptions{schedulingOptions},
+  _logsFirstIndex{0},
+  _logsSize{0},
+  _logLineLimit{FFmpegKitConfig::getLogRetentionLineLimit()},
+  _logByteLimit{FFmpegKitConfig::getLogRetentionByteLimit()},
+  _logStoreLevel{LevelAVLogTrace},
   _state{SessionStateCreated},
   _returnCode{nullptr},
   _logRedirectionStrategy{logRedirectionStrategy} {
 }
 
 void ffmpegkit::AbstractSession::waitForAsynchronousMessagesInTransmit(const int timeout) const {
-    std::mutex mutex;
-    std::unique_lock<std::mutex> lock(mutex);
-    std::condition_variable condition_variable;
-    const std::chrono::time_point<std::chrono::system_clock> expireTime = std::chrono::system_clock::now() + std::chrono::milliseconds(timeout);
-
-    while (this->thereAreAsynchronousMessagesInTransmit() && (std::chrono::system_clock::now() < expireTime)) {
-        condition_variable.wait_for(lock, std::chrono::milliseconds(100));
-    }
+    FFmpegKitConfig::waitForMessagesInTransmit(_sessionId, timeout);
 }
 
 ffmpegkit::LogCallback ffmpegkit::AbstractSession::getLogCallback() const {
@@ -86,6 +88,25 @@ long ffmpegkit::AbstractSession::getDuration() const {
     return 0;
 }
 
+std::chrono::time_point<std::chrono::system_clock> ffmpegkit::AbstractSession::getQueueTime() const {
+    return _queueTime;
+}
+
+long ffmpegkit::AbstractSession::getQueueDuration() const {
+    const std::chrono::time_point<std::chrono::system_clock> queueTime = _queueTime;
+    const std::chrono::time_point<std::chrono::system_clock> startTime = _startTime;
+
+    if (queueTime.time_since_epoch() != std::chrono::microseconds(0) && startTime.time_since_epoch() != std::chrono::microseconds(0)) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(startTime - queueTime).count();
+    }
+
+    return 0;
+}
+
+ffmpegkit::SchedulingOptions ffmpegkit::AbstractSession::getSchedulingOptions() const {
+    return _schedulingOptions;
+}
+
 std::shared_ptr<std::list<std::string>> ffmpegkit::AbstractSession::getArguments() const {
     return _arguments;
 }
@@ -108,7 +129,10 @@ std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::Log>>> ffmpegkit::AbstractS
 }
 
 std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::Log>>> ffmpegkit::AbstractSession::getLogs() const {
-    return _logs;
+    std::unique_lock<std::mutex> lock(_logsMutex, std::defer_lock);
+    lock.lock();
+
+    return std::make_shared<std::list<std::shared_ptr<ffmpegkit::Log>>>(_logs.cbegin(), _logs.cend());
 }
 
 std::string ffmpegkit::AbstractSession::getAllLogsAsStringWithTimeout(const int waitTimeout) const {
@@ -126,15 +150,52 @@ std::string ffmpegkit::AbstractSession::getAllLogsAsString() const {
 }
 
 std::string ffmpegkit::AbstractSession::getLogsAsString() const {
+    std::unique_lock<std::mutex> lock(_logsMutex, std::defer_lock);
     std::string concatenatedString;
 
-    std::for_each(_logs->cbegin(), _logs->cend(), [&](std::shared_ptr<ffmpegkit::Log> log) {
+    lock.lock();
+
+    concatenatedString.reserve(_logsSize);
+    std::for_each(_logs.cbegin(), _logs.cend(), [&](const std::shared_ptr<ffmpegkit::Log>& log) {
         concatenatedString.append(log->getMessage());
     });
 
     return concatenatedString;
 }
 
+std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::Log>>> ffmpegkit::AbstractSession::getLogsSince(long& cursor) const {
+    std::unique_lock<std::mutex> lock(_logsMutex, std::defer_lock);
+    auto logs = std::make_shared<std::list<std::shared_ptr<ffmpegkit::Log>>>();
+
+    lock.lock();
+
+    const long endIndex = _logsFirstIndex + (long)_logs.size();
+    const long startIndex = std::max(cursor, _logsFirstIndex);
+    if (startIndex < endIndex) {
+        logs->insert(logs->end(), _logs.cbegin() + (startIndex - _logsFirstIndex), _logs.cend());
+    }
+    cursor = std::max(cursor, endIndex);
+
+    return logs;
+}
+
+void ffmpegkit::AbstractSession::setLogRetention(const int lineLimit, const long byteLimit) {
+    std::unique_lock<std::mutex> lock(_logsMutex, std::defer_lock);
+    lock.lock();
+
+    _logLineLimit = std::max(lineLimit, 0);
+    _logByteLimit = std::max(byteLimit, 0L);
+    trimLogs();
+}
+
+void ffmpegkit::AbstractSession::setLogStoreLevel(const ffmpegkit::Level level) {
+    _logStoreLevel = level;
+}
+
+ffmpegkit::Level ffmpegkit::AbstractSession::getLogStoreLevel() const {
+    return _logStoreLevel;
+}
+
 std::string ffmpegkit::AbstractSession::getOutput() const {
     return this->getAllLogsAsString();
 }
@@ -160,7 +221,25 @@ bool ffmpegkit::AbstractSession::thereAreAsynchronousMessagesInTransmit() const
 }
 
 void ffmpegkit::AbstractSession::addLog(const std::shared_ptr<ffmpegkit::Log> log) {
-    _logs->push_back(log);
+    std::unique_lock<std::mutex> lock(_logsMutex, std::defer_lock);
+    lock.lock();
+
+    _logs.push_back(log);
+    _logsSize += log->getMessageLength();
+    trimLogs();
+}
+
+void ffmpegkit::AbstractSession::trimLogs() {
+    while (!_logs.empty() &&
+           ((_logLineLimit > 0 && _logs.size() > (size_t)_logLineLimit) || (_logByteLimit > 0 && _logsSize > _logByteLimit))) {
+        _logsSize -= _logs.front()->getMessageLength();
+        _logs.pop_front();
+        _logsFirstIndex++;
+    }
+}
+
+void ffmpegkit::AbstractSession::queue() {
+    _queueTime = std::chrono::system_clock::now();
 }
 
 void ffmpegkit::AbstractSession::startRunning() {
@@ -196,7 +275,7 @@ bool ffmpegkit::AbstractSession::isMediaInformation() const {
 }
 
 void ffmpegkit::AbstractSession::cancel() {
-    if (_state == SessionStateRunning) {
+    if (_state == SessionStateCreated || _state == SessionStateRunning) {
         FFmpegKit::cancel(_sessionId);
     }
 }
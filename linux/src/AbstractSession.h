@@ -21,6 +21,9 @@
 #define FFMPEG_KIT_ABSTRACT_SESSION_H
 
 #include "Session.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
 
 namespace ffmpegkit {
 
@@ -45,6 +48,16 @@ namespace ffmpegkit {
              */
             AbstractSession(const std::list<std::string>& arguments, const ffmpegkit::LogCallback logCallback, const LogRedirectionStrategy logRedirectionStrategy);
 
+            /**
+             * Creates a new abstract session.
+             *
+             * @param arguments              command arguments
+             * @param logCallback            session specific log callback
+             * @param logRedirectionStrategy session specific log redirection strategy
+             * @param schedulingOptions      session specific scheduling options
+             */
+            AbstractSession(const std::list<std::string>& arguments, const ffmpegkit::LogCallback logCallback, const LogRedirectionStrategy logRedirectionStrategy, const ffmpegkit::SchedulingOptions& schedulingOptions);
+
             /**
              * Waits for all asynchronous messages to be transmitted until the given timeout.
              *
@@ -95,6 +108,29 @@ namespace ffmpegkit {
              */
             long getDuration() const override;
 
+            /**
+             * Returns the time this session is submitted to an async executor queue.
+             *
+             * @return session queue time, empty if the session is not executed asynchronously
+             */
+            std::chrono::time_point<std::chrono::system_clock> getQueueTime() const override;
+
+            /**
+             * Returns the time this session waited in an async executor queue before it started.
+             * Time spent running is returned by getDuration.
+             *
+             * @return time spent in the queue in milliseconds or zero (0) if the session is not queued
+             * or not started yet
+             */
+            long getQueueDuration() const override;
+
+            /**
+             * Returns the scheduling options used when this session is executed asynchronously.
+             *
+             * @return scheduling options
+             */
+            ffmpegkit::SchedulingOptions getSchedulingOptions() const override;
+
             /**
              * Returns command arguments as a list.
              *
@@ -162,6 +198,43 @@ namespace ffmpegkit {
              */
             std::string getLogsAsString() const override;
 
+            /**
+             * Returns log entries delivered for this session after the given cursor and moves the cursor
+             * after the last entry returned. Start with a cursor of zero. Entries that are already
+             * removed because of log retention limits are skipped.
+             *
+             * @param cursor log cursor, updated by this method
+             * @return log entries delivered after the cursor
+             */
+            std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::Log>>> getLogsSince(long& cursor) const override;
+
+            /**
+             * Sets how many log entries this session keeps. When a limit is exceeded the oldest entries
+             * are removed. Zero means no limit. Sessions are created with the limits set using
+             * FFmpegKitConfig::setLogRetention.
+             *
+             * @param lineLimit maximum number of log entries
+             * @param byteLimit maximum total size of log messages in bytes
+             */
+            void setLogRetention(const int lineLimit, const long byteLimit) override;
+
+            /**
+             * Sets the most verbose level of log entries this session stores. Entries above this level
+             * are still forwarded to log callbacks and printed, but are not kept in the session. When
+             * no callback or print is configured for them, they are dropped before they are formatted.
+             * Must be set before the session is executed.
+             *
+             * @param level most verbose level of log entries stored
+             */
+            void setLogStoreLevel(const ffmpegkit::Level level) override;
+
+            /**
+             * Returns the most verbose level of log entries this session stores.
+             *
+             * @return most verbose level of log entries stored, LevelAVLogTrace by default
+             */
+            ffmpegkit::Level getLogStoreLevel() const override;
+
             /**
              * Returns the log output generated while running the session.
              *
@@ -223,6 +296,11 @@ namespace ffmpegkit {
              */
             void addLog(const std::shared_ptr<ffmpegkit::Log> log) override;
 
+            /**
+             * Marks the session as waiting in an async executor queue.
+             */
+            void queue() override;
+
             /**
              * Starts running the session.
              */
@@ -264,18 +342,34 @@ namespace ffmpegkit {
             virtual bool isMediaInformation() const override;
 
             /**
-             * Cancels running the session.
+             * Cancels running the session. Async sessions that are still queued are cancelled before
+             * they start.
              */
             void cancel() override;
 
         private:
+
+            /**
+             * Removes the oldest log entries until retention limits are met. Must be called while
+             * holding the logs mutex.
+             */
+            void trimLogs();
+
             const long _sessionId;
             ffmpegkit::LogCallback _logCallback;
             std::chrono::time_point<std::chrono::system_clock> _createTime;
             std::chrono::time_point<std::chrono::system_clock> _startTime;
             std::chrono::time_point<std::chrono::system_clock> _endTime;
+            std::chrono::time_point<std::chrono::system_clock> _queueTime;
+            ffmpegkit::SchedulingOptions _schedulingOptions;
             std::shared_ptr<std::list<std::string>> _arguments;
-            std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::Log>>> _logs;
+            std::deque<std::shared_ptr<ffmpegkit::Log>> _logs;
+            long _logsFirstIndex;
+            long _logsSize;
+            int _logLineLimit;
+            long _logByteLimit;
+            std::atomic<ffmpegkit::Level> _logStoreLevel;
+            mutable std::mutex _logsMutex;
             SessionState _state;
             std::shared_ptr<ffmpegkit::ReturnCode> _returnCode;
             std::string _failStackTrace;
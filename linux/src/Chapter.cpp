@@ -18,6 +18,7 @@
  */
 
 #include "Chapter.h"
+#include "MediaInformationJsonParser.h"
 
 ffmpegkit::Chapter::Chapter(std::shared_ptr<rapidjson::Value> chapterValue) : _chapterValue{chapterValue} {
 }
@@ -51,37 +52,32 @@ std::shared_ptr<rapidjson::Value> ffmpegkit::Chapter::getTags() {
 }
 
 std::shared_ptr<std::string> ffmpegkit::Chapter::getStringProperty(const char* key) {
-    if (_chapterValue->HasMember(key)) {
-        return std::make_shared<std::string>((*_chapterValue)[key].GetString());
+    const rapidjson::Value* value = ffmpegkit::MediaInformationJsonParser::findMember(_chapterValue.get(), key);
+    if (value != nullptr) {
+        return std::make_shared<std::string>(value->GetString(), value->GetStringLength());
     } else {
         return nullptr;
     }
 }
 
 std::shared_ptr<int64_t> ffmpegkit::Chapter::getNumberProperty(const char* key) {
-    if (_chapterValue->HasMember(key)) {
-        return std::make_shared<int64_t>((*_chapterValue)[key].GetInt64());
+    const rapidjson::Value* value = ffmpegkit::MediaInformationJsonParser::findMember(_chapterValue.get(), key);
+    if (value != nullptr) {
+        return std::make_shared<int64_t>(value->GetInt64());
     } else {
         return nullptr;
     }
 }
 
 std::shared_ptr<rapidjson::Value> ffmpegkit::Chapter::getProperty(const char* key) {
-    if (_chapterValue->HasMember(key)) {
-        auto value = std::make_shared<rapidjson::Value>();
-        *value = (*_chapterValue)[key];
-        return value;
+    rapidjson::Value* value = ffmpegkit::MediaInformationJsonParser::findMember(_chapterValue.get(), key);
+    if (value != nullptr) {
+        return std::shared_ptr<rapidjson::Value>(_chapterValue, value);
     } else {
         return nullptr;
     }
 }
 
 std::shared_ptr<rapidjson::Value> ffmpegkit::Chapter::getAllProperties() {
-    if (_chapterValue != nullptr) {
-        auto all = std::make_shared<rapidjson::Value>();
-        *all =  (*_chapterValue);
-        return all;
-    } else {
-        return nullptr;
-    }
+    return _chapterValue;
 }
@@ -31,6 +31,8 @@ namespace ffmpegkit {
 
     /**
      * Chapter class.
+     *
+     * <p>Values returned by property getters point into the media information document.
      */
     class Chapter {
         public:
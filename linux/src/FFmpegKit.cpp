@@ -27,6 +27,7 @@ extern "C" {
 }
 
 extern void* ffmpegKitInitialize();
+extern void cancelQueuedSessions(const long sessionId);
 
 const void* _ffmpegKitInitializeri{ffmpegKitInitialize()};
 
@@ -72,10 +73,12 @@ void ffmpegkit::FFmpegKit::cancel() {
      * ZERO (0) IS A SPECIAL SESSION ID
      * WHEN IT IS PASSED TO THIS METHOD, A SIGINT IS GENERATED WHICH CANCELS ALL ONGOING SESSIONS
      */
+    cancelQueuedSessions(0);
     cancel_operation(0);
 }
 
 void ffmpegkit::FFmpegKit::cancel(const long sessionId) {
+    cancelQueuedSessions(sessionId);
     cancel_operation(sessionId);
 }
 
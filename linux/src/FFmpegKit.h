@@ -117,14 +117,16 @@ namespace ffmpegkit {
             static std::shared_ptr<ffmpegkit::FFmpegSession> executeAsync(const std::string command, FFmpegSessionCompleteCallback completeCallback, ffmpegkit::LogCallback logCallback, ffmpegkit::StatisticsCallback statisticsCallback);
 
             /**
-             * <p>Cancels all running sessions.
+             * <p>Cancels all running sessions. Async sessions waiting in the queue are completed with the
+             * cancel return code without being started.
              *
              * <p>This method does not wait for termination to complete and returns immediately.
              */
             static void cancel();
 
             /**
-             * <p>Cancels the session specified with <code>sessionId</code>.
+             * <p>Cancels the session specified with <code>sessionId</code>. If it is an async session
+             * waiting in the queue, it is completed with the cancel return code without being started.
              *
              * <p>This method does not wait for termination to complete and returns immediately.
              *
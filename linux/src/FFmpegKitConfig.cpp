@@ -23,7 +23,9 @@
 extern "C" {
     #include "libavutil/ffversion.h"
     #include "libavutil/bprint.h"
+    #include "libavformat/avformat.h"
     #include "fftools_cmdutils.h"
+    #include "fftools_stream_report.h"
 }
 #include "ArchDetect.h"
 #include "FFmpegKit.h"
@@ -33,6 +35,8 @@ extern "C" {
 #include "FFprobeSession.h"
 #include "Level.h"
 #include "LogRedirectionStrategy.h"
+#include "MediaInformationCache.h"
+#include "MediaInformationNativeParser.h"
 #include "MediaInformationSession.h"
 #include "Packages.h"
 #include "SessionState.h"
@@ -43,10 +47,15 @@ extern "C" {
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <deque>
+#include <functional>
+#include <set>
+#include <thread>
 
 extern "C" {
     void set_report_callback(void (*callback)(int, float, float, int64_t, double, double, double));
     void cancel_operation(long id);
+    void set_ffprobe_output_buffer(AVBPrint *buffer);
 }
 
 /**
@@ -56,21 +65,86 @@ static std::atomic<long> pipeIndexGenerator(1);
 
 /* Session history variables */
 static int sessionHistorySize;
+static std::atomic<int> logRetentionLineLimit(0);
+static std::atomic<long> logRetentionByteLimit(0);
+static std::atomic<int> statisticsRetention(1000);
+static std::atomic<int> statisticsMaxRate(0);
 static std::map<long, std::shared_ptr<ffmpegkit::Session>> sessionHistoryMap;
 static std::list<std::shared_ptr<ffmpegkit::Session>> sessionHistoryList;
 static std::recursive_mutex sessionMutex;
 
+typedef std::list<std::shared_ptr<ffmpegkit::StreamStatistics>> StreamStatisticsList;
+
+/**
+ * Latest statistics of a session. The session thread writes it as a sequence lock, the sequence is
+ * odd while an update is in progress.
+ *
+ * <p>Only one callback entry is queued for a session at a time. Updates received while an entry is
+ * queued overwrite the values it delivers.
+ */
+struct StatisticsSnapshot {
+    std::atomic<unsigned> sequence;
+    std::atomic<int> videoFrameNumber;
+    std::atomic<float> videoFps;
+    std::atomic<float> videoQuality;
+    std::atomic<int64_t> size;
+    std::atomic<double> time;
+    std::atomic<double> bitrate;
+    std::atomic<double> speed;
+    std::shared_ptr<StreamStatisticsList> streams;  // latest stream statistics, accessed with std::atomic_load/store
+
+    std::atomic<bool> queued;               // a callback entry is queued for these values
+    std::atomic<unsigned> delivered;        // sequence of the values delivered last
+    int64_t queueTime;                      // time the last entry was queued, used by the session thread only
+    int64_t queueInterval;                  // minimum time between two entries, used by the session thread only
+};
+
+/**
+ * Control block of a session, held while the session is executing or has messages in transmit.
+ *
+ * <p>Blocks are kept in an open-addressed table keyed by session id. A block is released and its
+ * slot becomes reusable when its reference count drops to zero. Cancel requests store the id of the
+ * cancelled session rather than a flag, so a request can never apply to a later session that
+ * reuses the same slot.
+ */
+struct SessionControl {
+    std::atomic<long> sessionId;
+    std::atomic<long> cancelledSessionId;
+    std::atomic<int> references;
+    std::atomic<int> messagesInTransmit;
+    std::atomic<int> logSinkMask;
+    std::atomic<int> logStoreLevel;
+    StatisticsSnapshot statistics;
+};
+
+/**
+ * Log sinks of a session, resolved when the session starts. The global log callback is not part
+ * of the mask because it can be changed while sessions are running.
+ */
+#define LOG_SINK_SESSION_CALLBACK               (1 << 0)    // session log callback defined
+#define LOG_SINK_PRINT                          (1 << 1)    // logs are printed
+#define LOG_SINK_PRINT_WITHOUT_GLOBAL_CALLBACK  (1 << 2)    // logs are printed if no global log callback is defined
+
+/**
+ * Session control table size. Must be a power of two. Only sessions that are executing or have
+ * messages in transmit occupy a slot.
+ */
+#define SESSION_CONTROL_TABLE_SIZE 4096
+
 /** Session control variables */
-#define SESSION_MAP_SIZE 1000
-static std::atomic<short> sessionMap[SESSION_MAP_SIZE];
-static std::atomic<int> sessionInTransitMessageCountMap[SESSION_MAP_SIZE];
+static SessionControl sessionControlTable[SESSION_CONTROL_TABLE_SIZE];
+static std::atomic<int> sessionControlMaxProbe(0);
 
 /** Holds callback defined to redirect logs */
 static ffmpegkit::LogCallback logCallback;
+static std::atomic<bool> logCallbackDefined(false);
 
 /** Holds callback defined to redirect statistics */
 static ffmpegkit::StatisticsCallback statisticsCallback;
 
+/** Holds callback defined to redirect stream statistics */
+static ffmpegkit::StreamStatisticsCallback streamStatisticsCallback;
+
 /** Holds complete callbacks defined to redirect asynchronous execution results */
 static ffmpegkit::FFmpegSessionCompleteCallback ffmpegSessionCompleteCallback;
 static ffmpegkit::FFprobeSessionCompleteCallback ffprobeSessionCompleteCallback;
@@ -83,8 +157,44 @@ static int redirectionEnabled;
 static std::recursive_mutex callbackDataMutex;
 static std::mutex callbackMutex;
 static std::condition_variable callbackMonitor;
+static std::atomic<bool> callbackThreadWaiting(false);
+
+/** Signalled when the number of messages in transmit for a session drops to zero */
+static std::mutex messagesInTransmitMutex;
+static std::condition_variable messagesInTransmitMonitor;
 class CallbackData;
-static std::list<CallbackData*> callbackDataList;
+struct CallbackSlot;
+
+/**
+ * Callback data ring size. Must be a power of two.
+ */
+#define CALLBACK_RING_SIZE 2048
+
+/**
+ * Log lines shorter than this many bytes are stored inside the ring slot, longer lines are
+ * allocated on the heap.
+ */
+#define CALLBACK_INLINE_LOG_SIZE 256
+
+/**
+ * Maximum length of a log line, longer lines are truncated.
+ */
+#define CALLBACK_MAX_LOG_SIZE 65536
+
+/** Lock-free multi-producer/single-consumer callback data ring */
+static CallbackSlot* callbackRing;
+static std::atomic<size_t> callbackRingEnqueuePosition(0);
+static size_t callbackRingDequeuePosition = 0;
+
+/** Overflow list used when the ring is full, guarded by callbackDataMutex */
+static std::list<CallbackData*> callbackOverflowList;
+static std::atomic<int> callbackOverflowCount(0);
+
+class AsyncExecutor;
+
+/** Executors that run asynchronous FFmpeg and FFprobe/media information sessions */
+static AsyncExecutor* ffmpegAsyncExecutor;
+static AsyncExecutor* ffprobeAsyncExecutor;
 
 /** Fields that control the handling of SIGNALs */
 volatile int handleSIGQUIT = 1;
@@ -96,6 +206,9 @@ volatile int handleSIGPIPE = 1;
 /** Holds the id of the current execution */
 __thread long globalSessionId = 0;
 
+/** Holds the control block of the current execution */
+static __thread SessionControl* globalSessionControl = nullptr;
+
 /** Holds the default log level */
 int configuredLogLevel = ffmpegkit::LevelAVLogInfo;
 
@@ -127,6 +240,199 @@ enum CallbackType {
     StatisticsType
 };
 
+/**
+ * Runs asynchronous sessions on a bounded number of worker threads. Sessions submitted while all
+ * workers are busy wait in a queue and stay in the created state until a worker picks them up.
+ * The queue is ordered by priority, then by deadline, then by submission order.
+ *
+ * <p>Workers are created on demand and are kept alive after their first task. When the limit is
+ * lowered, extra workers exit after completing their current task.
+ */
+class AsyncExecutor {
+    public:
+        AsyncExecutor(const int concurrencyLimit) : _concurrencyLimit{concurrencyLimit}, _workerCount{0}, _idleWorkerCount{0}, _sequence{0} {
+        }
+
+        int getConcurrencyLimit() {
+            std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+            lock.lock();
+
+            return _concurrencyLimit;
+        }
+
+        void setConcurrencyLimit(const int concurrencyLimit) {
+            std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+            lock.lock();
+
+            _concurrencyLimit = concurrencyLimit;
+            startWorkers();
+
+            // IDLE WORKERS ABOVE THE NEW LIMIT EXIT WHEN THEY WAKE UP
+            _monitor.notify_all();
+        }
+
+        /**
+         * Queues a task for the given session. The task is called with cancelled set, on the
+         * cancelling thread, if its session is cancelled before it starts, and with throttled set
+         * if it should use fewer threads because sessions with a higher priority are running or
+         * waiting.
+         */
+        void submit(const std::shared_ptr<ffmpegkit::Session> session, const std::function<void(bool, bool)>& task) {
+            std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+            const ffmpegkit::SchedulingOptions schedulingOptions = session->getSchedulingOptions();
+            std::chrono::time_point<std::chrono::system_clock> deadline = std::chrono::time_point<std::chrono::system_clock>::max();
+
+            if (schedulingOptions.getDeadline() > 0) {
+                deadline = session->getCreateTime() + std::chrono::milliseconds(schedulingOptions.getDeadline());
+            }
+
+            session->queue();
+
+            lock.lock();
+
+            Task newTask{session->getSessionId(), schedulingOptions.getPriority(), deadline, _sequence++, schedulingOptions.getThrottledThreadCount() > 0, task};
+            _queue.insert(std::upper_bound(_queue.begin(), _queue.end(), newTask, startsBefore), std::move(newTask));
+            startWorkers();
+            _monitor.notify_one();
+        }
+
+        /**
+         * Removes queued tasks of the given session and runs them with cancelled set on the calling
+         * thread, so their sessions complete without waiting for a worker. Zero cancels all queued
+         * tasks.
+         */
+        void cancel(const long sessionId) {
+            std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+            std::deque<Task> cancelledTasks;
+
+            lock.lock();
+
+            for (auto it = _queue.begin(); it != _queue.end();) {
+                if (sessionId == 0 || it->sessionId == sessionId) {
+                    cancelledTasks.push_back(std::move(*it));
+                    it = _queue.erase(it);
+                } else {
+                    it++;
+                }
+            }
+
+            lock.unlock();
+
+            for (auto it = cancelledTasks.begin(); it != cancelledTasks.end(); it++) {
+                try {
+                    it->run(true, false);
+                } catch(const std::exception& exception) {
+                    std::cout << "Exception thrown inside async session task. " << exception.what() << std::endl;
+                }
+            }
+        }
+
+    private:
+        struct Task {
+            long sessionId;
+            int priority;
+            std::chrono::time_point<std::chrono::system_clock> deadline;
+            long sequence;
+            bool throttleEnabled;
+            std::function<void(bool, bool)> run;
+        };
+
+        static bool startsBefore(const Task& first, const Task& second) {
+            if (first.priority != second.priority) {
+                return first.priority > second.priority;
+            } else if (first.deadline != second.deadline) {
+                return first.deadline < second.deadline;
+            } else {
+                return first.sequence < second.sequence;
+            }
+        }
+
+        /**
+         * Checks whether a task with the given priority should be throttled. Must be called while
+         * holding the executor mutex.
+         */
+        bool higherPriorityPending(const int priority) {
+            return (!_runningPriorities.empty() && *_runningPriorities.rbegin() > priority) ||
+                (!_queue.empty() && _queue.front().priority > priority);
+        }
+
+        /**
+         * Starts new workers if there are more queued tasks than idle workers. Must be called while
+         * holding the executor mutex.
+         */
+        void startWorkers() {
+            while (_workerCount < _concurrencyLimit && (size_t)_idleWorkerCount < _queue.size()) {
+                std::thread(&AsyncExecutor::work, this).detach();
+                _workerCount++;
+                _idleWorkerCount++;
+            }
+        }
+
+        void work() {
+            std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+
+            while (true) {
+                lock.lock();
+
+                _monitor.wait(lock, [this]() { return !_queue.empty() || _workerCount > _concurrencyLimit; });
+
+                if (_workerCount > _concurrencyLimit) {
+                    _workerCount--;
+                    _idleWorkerCount--;
+                    return;
+                }
+
+                Task task = std::move(_queue.front());
+                _queue.pop_front();
+                _idleWorkerCount--;
+
+                const bool throttled = task.throttleEnabled && higherPriorityPending(task.priority);
+                auto runningPriority = _runningPriorities.insert(task.priority);
+
+                lock.unlock();
+
+                try {
+                    task.run(false, throttled);
+                } catch(const std::exception& exception) {
+                    std::cout << "Exception thrown inside async session task. " << exception.what() << std::endl;
+                }
+
+                lock.lock();
+                _runningPriorities.erase(runningPriority);
+                _idleWorkerCount++;
+                lock.unlock();
+            }
+        }
+
+        std::mutex _mutex;
+        std::condition_variable _monitor;
+        std::deque<Task> _queue;
+        std::multiset<int> _runningPriorities;
+        int _concurrencyLimit;
+        int _workerCount;
+        int _idleWorkerCount;
+        long _sequence;
+};
+
+/**
+ * Cancels sessions waiting in async executor queues.
+ *
+ * @param sessionId session id, zero cancels all queued sessions
+ */
+void cancelQueuedSessions(const long sessionId) {
+    ffmpegAsyncExecutor->cancel(sessionId);
+    ffprobeAsyncExecutor->cancel(sessionId);
+}
+
+/**
+ * Completes a session that is cancelled before leaving the async executor queue.
+ *
+ * @param session session cancelled
+ */
+static void completeQueuedSessionAsCancelled(const std::shared_ptr<ffmpegkit::Session> session) {
+    session->complete(std::make_shared<ffmpegkit::ReturnCode>(static_cast<int>(ffmpegkit::ReturnCode::Cancel)));
+}
+
 static bool fs_exists(const std::string& s, const bool isFile, const bool isDirectory) {
     struct stat dir_info;
 
@@ -187,29 +493,73 @@ void addSessionToSessionHistory(const std::shared_ptr<ffmpegkit::Session> sessio
  */
 class CallbackData {
     public:
-        CallbackData(const long sessionId, const  int logLevel, const AVBPrint* data) :
-            _type{LogType}, _sessionId{sessionId}, _logLevel{logLevel} {
-                av_bprint_init(&_logData, 0, AV_BPRINT_SIZE_UNLIMITED);
-                av_bprintf(&_logData, "%s", data->str);
-        }
-
-        CallbackData(const long sessionId,
-                     const int videoFrameNumber,
-                     const float videoFps,
-                     const float videoQuality,
-                     const int64_t size,
-                     const double time,
-                     const double bitrate,
-                     const double speed) :
-                        _type{StatisticsType},
-                        _sessionId{sessionId},
-                        _statisticsFrameNumber{videoFrameNumber},
-                        _statisticsFps{videoFps},
-                        _statisticsQuality{videoQuality},
-                        _statisticsSize{size},
-                        _statisticsTime{time},
-                        _statisticsBitrate{bitrate},
-                        _statisticsSpeed{speed} {
+        CallbackData() : _sessionControl{nullptr}, _logOverflow{nullptr}, _logLength{0} {
+            _logInline[0] = '\0';
+        }
+
+        ~CallbackData() {
+            reset();
+        }
+
+        /**
+         * Starts a log entry. The log line is written into the returned buffer, which holds
+         * CALLBACK_INLINE_LOG_SIZE bytes, and completed with setLogLength.
+         *
+         * @param sessionId session id
+         * @param logLevel log level
+         * @return buffer to write the log line into
+         */
+        char* beginLog(const long sessionId, const int logLevel) {
+            _type = LogType;
+            _sessionId = sessionId;
+            _logLevel = logLevel;
+            _logLength = 0;
+            return _logInline;
+        }
+
+        /**
+         * Replaces the inline buffer of a log entry with a heap buffer for long lines.
+         *
+         * @param length log line length
+         * @return buffer holding length + 1 bytes or nullptr if it can not be allocated
+         */
+        char* growLog(const size_t length) {
+            _logOverflow = (char*)av_malloc(length + 1);
+            return _logOverflow;
+        }
+
+        void setLogLength(const size_t length) {
+            _logLength = length;
+        }
+
+        void setStatistics(const long sessionId,
+                           const int videoFrameNumber,
+                           const float videoFps,
+                           const float videoQuality,
+                           const int64_t size,
+                           const double time,
+                           const double bitrate,
+                           const double speed) {
+            _type = StatisticsType;
+            _sessionId = sessionId;
+            _statisticsFrameNumber = videoFrameNumber;
+            _statisticsFps = videoFps;
+            _statisticsQuality = videoQuality;
+            _statisticsSize = size;
+            _statisticsTime = time;
+            _statisticsBitrate = bitrate;
+            _statisticsSpeed = speed;
+        }
+
+        /**
+         * Releases the heap buffer allocated for long log lines, if any.
+         */
+        void reset() {
+            if (_logOverflow != nullptr) {
+                av_free(_logOverflow);
+                _logOverflow = nullptr;
+            }
+            _logLength = 0;
         }
 
         CallbackType getType() {
@@ -220,12 +570,24 @@ class CallbackData {
             return _sessionId;
         }
 
+        void setSessionControl(SessionControl* sessionControl) {
+            _sessionControl = sessionControl;
+        }
+
+        SessionControl* getSessionControl() {
+            return _sessionControl;
+        }
+
         int getLogLevel() {
             return _logLevel;
         }
 
-        AVBPrint* getLogData() {
-            return &_logData;
+        const char* getLogData() {
+            return (_logOverflow != nullptr) ? _logOverflow : _logInline;
+        }
+
+        size_t getLogLength() {
+            return _logLength;
         }
 
         int getStatisticsFrameNumber() {
@@ -259,9 +621,12 @@ class CallbackData {
     private:
         CallbackType _type;
         long _sessionId;                    // session id
+        SessionControl* _sessionControl;    // control block holding a reference for this entry
 
         int _logLevel;                      // log level
-        AVBPrint _logData;                  // log data
+        char* _logOverflow;                 // log data, used for long lines
+        size_t _logLength;                  // log data length
+        char _logInline[CALLBACK_INLINE_LOG_SIZE];  // log data, used for short lines
 
         int _statisticsFrameNumber;         // statistics frame number
         float _statisticsFps;               // statistics fps
@@ -273,22 +638,135 @@ class CallbackData {
 };
 
 /**
- * Waits on the callback semaphore for the given time.
+ * A pre-allocated callback ring slot.
+ *
+ * The sequence number tells producers and the consumer who owns the slot: it is equal to the
+ * enqueue position when the slot is free, and to the enqueue position plus one when it holds
+ * published data.
+ */
+struct CallbackSlot {
+    std::atomic<size_t> sequence;
+    CallbackData data;
+};
+
+/**
+ * Initialises the callback ring.
+ */
+static void callbackRingInit() {
+    callbackRing = new CallbackSlot[CALLBACK_RING_SIZE];
+    for (size_t i = 0; i < CALLBACK_RING_SIZE; i++) {
+        std::atomic_init(&callbackRing[i].sequence, i);
+    }
+}
+
+/**
+ * Claims a free slot in the callback ring. Safe to call from multiple producer threads.
+ *
+ * @return claimed slot or nullptr if the ring is full
+ */
+static CallbackSlot* callbackRingAcquire() {
+    size_t position = callbackRingEnqueuePosition.load(std::memory_order_relaxed);
+
+    for (;;) {
+        CallbackSlot* slot = &callbackRing[position & (CALLBACK_RING_SIZE - 1)];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+        if (difference == 0) {
+            if (callbackRingEnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                return slot;
+            }
+        } else if (difference < 0) {
+            return nullptr;
+        } else {
+            position = callbackRingEnqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Makes a claimed slot visible to the consumer.
+ *
+ * @param slot slot claimed with callbackRingAcquire
+ */
+static void callbackRingPublish(CallbackSlot* slot) {
+    slot->sequence.store(slot->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+/**
+ * Returns the head of the callback ring without removing it. Must only be called from the
+ * callback thread.
  *
- * @param milliSeconds wait time in milliseconds
+ * @return callback data at the head of the ring or nullptr if the ring is empty
+ */
+static CallbackData* callbackRingPeek() {
+    CallbackSlot* slot = &callbackRing[callbackRingDequeuePosition & (CALLBACK_RING_SIZE - 1)];
+    if (slot->sequence.load(std::memory_order_acquire) == callbackRingDequeuePosition + 1) {
+        return &slot->data;
+    }
+    return nullptr;
+}
+
+/**
+ * Checks whether all slots claimed in the callback ring are processed. A ring that is not empty may
+ * still have no published head, when a producer claimed the head slot and is filling it. Must only
+ * be called from the callback thread.
+ *
+ * @return true if there are no claimed slots in the ring
+ */
+static bool callbackRingEmpty() {
+    return callbackRingEnqueuePosition.load(std::memory_order_acquire) == callbackRingDequeuePosition;
+}
+
+/**
+ * Gives the head of the callback ring back to producers. Must only be called from the
+ * callback thread.
  */
-static void callbackWait(int milliSeconds) {
+static void callbackRingRelease() {
+    CallbackSlot* slot = &callbackRing[callbackRingDequeuePosition & (CALLBACK_RING_SIZE - 1)];
+    slot->data.reset();
+    slot->sequence.store(callbackRingDequeuePosition + CALLBACK_RING_SIZE, std::memory_order_release);
+    callbackRingDequeuePosition++;
+}
+
+/**
+ * Waits on the callback semaphore until new callback data is published or redirection is
+ * disabled.
+ */
+static void callbackWait() {
     std::unique_lock<std::mutex> callbackLock{callbackMutex};
-    callbackMonitor.wait_for(callbackLock, std::chrono::milliseconds(milliSeconds));
+
+    // PRODUCERS ONLY NOTIFY WHEN THIS FLAG IS SET, SO THE QUEUE MUST BE CHECKED AGAIN AFTER SETTING IT
+    std::atomic_store(&callbackThreadWaiting, true);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // OVERFLOW ENTRIES WAIT FOR THE SLOTS CLAIMED BEFORE THEM, WHICH NOTIFY WHEN THEY ARE PUBLISHED
+    if (redirectionEnabled && callbackRingPeek() == nullptr && (std::atomic_load(&callbackOverflowCount) == 0 || !callbackRingEmpty())) {
+        callbackMonitor.wait(callbackLock);
+    }
+
+    std::atomic_store(&callbackThreadWaiting, false);
 }
 
 /**
  * Notifies threads waiting on callback semaphore.
  */
 static void callbackNotify() {
+    std::unique_lock<std::mutex> callbackLock{callbackMutex};
     callbackMonitor.notify_one();
 }
 
+/**
+ * Notifies the callback thread if it is waiting for new callback data. Called by producers
+ * after publishing an entry, so it does not take any lock while the callback thread is busy.
+ */
+static void callbackNotifyIfWaiting() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (std::atomic_load(&callbackThreadWaiting)) {
+        callbackNotify();
+    }
+}
+
 static const char *avutil_log_get_level_str(int level) {
     switch (level) {
     case AV_LOG_STDERR:
@@ -314,114 +792,423 @@ static const char *avutil_log_get_level_str(int level) {
     }
 }
 
-static void avutil_log_format_line(void *avcl, int level, const char *fmt, va_list vl, AVBPrint part[4], int *print_prefix) {
-    int flags = av_log_get_flags();
+/**
+ * Replaces control characters other than backspace, tab and line breaks with '?'. Eight bytes are
+ * checked at a time, so only the words that contain a byte below 0x20 are inspected byte by byte.
+ *
+ * @param line log line
+ * @param length log line length
+ */
+static void avutil_log_sanitize(char *line, size_t length) {
+    const uint64_t ones = UINT64_C(0x0101010101010101);
+    uint8_t *data = (uint8_t *)line;
+    size_t i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        if (((word - ones * 0x20) & ~word & (ones * 0x80)) == 0) {
+            continue;
+        }
+        for (size_t j = i; j < i + 8; j++) {
+            if (data[j] < 0x08 || (data[j] > 0x0D && data[j] < 0x20)) {
+                data[j] = '?';
+            }
+        }
+    }
+    for (; i < length; i++) {
+        if (data[i] < 0x08 || (data[i] > 0x0D && data[i] < 0x20)) {
+            data[i] = '?';
+        }
+    }
+}
+
+/**
+ * Formats a log line in the format used by av_log_default_callback, without allocating. Like
+ * snprintf, the output is truncated to size - 1 bytes and the length of the full line is
+ * returned. The written part of the line is sanitised.
+ *
+ * @param buffer output buffer
+ * @param size output buffer size
+ * @param avcl pointer to AVClass struct
+ * @param level log level
+ * @param fmt format string
+ * @param vl arguments
+ * @return length of the full log line
+ */
+static size_t avutil_log_format_line(char *buffer, size_t size, void *avcl, int level, const char *fmt, va_list vl) {
     AVClass* avc = avcl ? *(AVClass **) avcl : NULL;
-    av_bprint_init(part+0, 0, 1);
-    av_bprint_init(part+1, 0, 1);
-    av_bprint_init(part+2, 0, 1);
-    av_bprint_init(part+3, 0, 65536);
+    size_t length = 0;
+    size_t offset;
+    int written;
 
-    if (*print_prefix && avc) {
+    if (avc) {
         if (avc->parent_log_context_offset) {
             AVClass** parent = *(AVClass ***) (((uint8_t *) avcl) +
                                    avc->parent_log_context_offset);
             if (parent && *parent) {
-                av_bprintf(part+0, "[%s @ %p] ",
-                         (*parent)->item_name(parent), parent);
+                written = snprintf(buffer, size, "[%s @ %p] ", (*parent)->item_name(parent), parent);
+                length += std::max(written, 0);
             }
         }
-        av_bprintf(part+1, "[%s @ %p] ",
-                 avc->item_name(avcl), avcl);
+        offset = std::min(length, size - 1);
+        written = snprintf(buffer + offset, size - offset, "[%s @ %p] ", avc->item_name(avcl), avcl);
+        length += std::max(written, 0);
     }
 
-    if (*print_prefix && (level > AV_LOG_QUIET) && (flags & AV_LOG_PRINT_LEVEL))
-        av_bprintf(part+2, "[%s] ", avutil_log_get_level_str(level));
+    if ((level > AV_LOG_QUIET) && (av_log_get_flags() & AV_LOG_PRINT_LEVEL)) {
+        offset = std::min(length, size - 1);
+        written = snprintf(buffer + offset, size - offset, "[%s] ", avutil_log_get_level_str(level));
+        length += std::max(written, 0);
+    }
 
-    av_vbprintf(part+3, fmt, vl);
+    offset = std::min(length, size - 1);
+    written = vsnprintf(buffer + offset, size - offset, fmt, vl);
+    length += std::max(written, 0);
 
-    if(*part[0].str || *part[1].str || *part[2].str || *part[3].str) {
-        char lastc = part[3].len && part[3].len <= part[3].size ? part[3].str[part[3].len - 1] : 0;
-        *print_prefix = lastc == '\n' || lastc == '\r';
+    avutil_log_sanitize(buffer, std::min(length, size - 1));
+
+    return length;
+}
+
+/**
+ * Claims space for a new callback data entry. Entries are written into the lock-free ring
+ * unless the ring is full or older entries are still waiting in the overflow list, in which
+ * case a heap entry is created so the order of entries produced by a thread is preserved.
+ *
+ * @param slot set to the claimed ring slot or nullptr if a heap entry is created
+ * @return callback data entry to fill
+ */
+static CallbackData* callbackDataAcquire(CallbackSlot** slot) {
+    *slot = nullptr;
+    if (std::atomic_load(&callbackOverflowCount) == 0) {
+        *slot = callbackRingAcquire();
     }
+
+    return (*slot != nullptr) ? &(*slot)->data : new CallbackData();
 }
 
-static void avutil_log_sanitize(char *line) {
-    while(*line){
-        if(*line < 0x08 || (*line > 0x0D && *line < 0x20))
-            *line='?';
-        line++;
+/**
+ * Finds the control block of a session.
+ *
+ * @param sessionId session id
+ * @return control block or nullptr if the session is not executing and has no messages in transmit
+ */
+static SessionControl* sessionControlFind(long sessionId);
+
+/**
+ * Publishes a callback data entry claimed with callbackDataAcquire.
+ *
+ * @param slot ring slot claimed or nullptr for heap entries
+ * @param callbackData callback data entry
+ */
+static void callbackDataPublish(CallbackSlot* slot, CallbackData* callbackData) {
+    SessionControl* sessionControl = globalSessionControl;
+
+    // DECODER, ENCODER AND FILTER THREADS ONLY KNOW THE SESSION ID, THE SESSION THREAD HOLDS THE BLOCK UNTIL THEY ARE JOINED
+    if (sessionControl == nullptr && globalSessionId != 0) {
+        sessionControl = sessionControlFind(globalSessionId);
+    }
+
+    // ENTRIES KEEP THE CONTROL BLOCK OF THEIR SESSION UNTIL THEY ARE PROCESSED
+    if (sessionControl != nullptr) {
+        std::atomic_fetch_add(&sessionControl->references, 1);
+        std::atomic_fetch_add(&sessionControl->messagesInTransmit, 1);
+    }
+    callbackData->setSessionControl(sessionControl);
+
+    if (slot != nullptr) {
+        callbackRingPublish(slot);
+    } else {
+        std::unique_lock<std::recursive_mutex> lock(callbackDataMutex, std::defer_lock);
+
+        lock.lock();
+        callbackOverflowList.push_back(callbackData);
+        std::atomic_fetch_add(&callbackOverflowCount, 1);
+        lock.unlock();
     }
+
+    callbackNotifyIfWaiting();
 }
 
 /**
- * Adds log data to the end of callback data list.
+ * Formats a log line directly into a new callback data entry and adds it to the end of callback
+ * data queue.
  *
+ * @param avcl pointer to AVClass struct
  * @param level log level
- * @param data log data
+ * @param format format string
+ * @param vargs arguments
+ */
+static void logCallbackDataAdd(void *avcl, int level, const char* format, va_list vargs) {
+    CallbackSlot* slot;
+    CallbackData* callbackData = callbackDataAcquire(&slot);
+    va_list retryArgs;
+
+    va_copy(retryArgs, vargs);
+
+    char* buffer = callbackData->beginLog(globalSessionId, level);
+    size_t length = avutil_log_format_line(buffer, CALLBACK_INLINE_LOG_SIZE, avcl, level, format, vargs);
+
+    // LONG LINES ARE FORMATTED AGAIN INTO A HEAP BUFFER OF THE RIGHT SIZE
+    if (length >= CALLBACK_INLINE_LOG_SIZE) {
+        length = std::min(length, (size_t)CALLBACK_MAX_LOG_SIZE - 1);
+        buffer = callbackData->growLog(length);
+        if (buffer != nullptr) {
+            avutil_log_format_line(buffer, length + 1, avcl, level, format, retryArgs);
+        } else {
+            length = CALLBACK_INLINE_LOG_SIZE - 1;
+        }
+    }
+
+    va_end(retryArgs);
+
+    callbackData->setLogLength(length);
+
+    callbackDataPublish(slot, callbackData);
+}
+
+/**
+ * Prepares the statistics snapshot of a control block for a new session. Must be called from the
+ * session thread.
+ *
+ * @param snapshot statistics snapshot
+ */
+static void statisticsSnapshotReset(StatisticsSnapshot* snapshot) {
+    const int maxRate = statisticsMaxRate;
+
+    std::atomic_store(&snapshot->sequence, 0U);
+    std::atomic_store(&snapshot->queued, false);
+    std::atomic_store(&snapshot->delivered, 0U);
+    std::atomic_store(&snapshot->streams, std::shared_ptr<StreamStatisticsList>());
+    snapshot->queueTime = 0;
+    snapshot->queueInterval = (maxRate > 0) ? 1000000 / maxRate : 0;
+}
+
+/**
+ * Stores the latest statistics of a session. Must be called from the session thread.
+ */
+static void statisticsSnapshotWrite(StatisticsSnapshot* snapshot, int frameNumber, float fps, float quality, int64_t size, double time, double bitrate, double speed) {
+    const unsigned sequence = snapshot->sequence.load(std::memory_order_relaxed);
+
+    snapshot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    snapshot->videoFrameNumber.store(frameNumber, std::memory_order_relaxed);
+    snapshot->videoFps.store(fps, std::memory_order_relaxed);
+    snapshot->videoQuality.store(quality, std::memory_order_relaxed);
+    snapshot->size.store(size, std::memory_order_relaxed);
+    snapshot->time.store(time, std::memory_order_relaxed);
+    snapshot->bitrate.store(bitrate, std::memory_order_relaxed);
+    snapshot->speed.store(speed, std::memory_order_relaxed);
+
+    snapshot->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+/**
+ * Queues a callback entry that delivers the latest statistics of the current execution, unless
+ * one is already queued or the previous one was queued less than the statistics interval ago.
+ * Must be called from the session thread.
+ *
+ * @param sessionControl control block of the current execution
+ * @param last true for the last update of the session, which is queued regardless of the interval
  */
-static void logCallbackDataAdd(int level, AVBPrint *data) {
+static void statisticsSnapshotQueue(SessionControl* sessionControl, bool last) {
+    StatisticsSnapshot* snapshot = &sessionControl->statistics;
+
+    // ORDERS THE SEQUENCE STORE OF THE LAST WRITE BEFORE THE QUEUED LOAD, PAIRED WITH THE FENCE IN
+    // statisticsSnapshotProcess, SO EITHER AN ENTRY IS QUEUED OR THE QUEUED ENTRY READS THE UPDATE
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (std::atomic_load(&snapshot->queued)) {
+        return;
+    }
+
+    const int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (last) {
+        if (std::atomic_load(&snapshot->delivered) == snapshot->sequence.load(std::memory_order_relaxed)) {
+            return;
+        }
+    } else if (snapshot->queueTime != 0 && now - snapshot->queueTime < snapshot->queueInterval) {
+        return;
+    }
+
+    snapshot->queueTime = now;
+    std::atomic_store(&snapshot->queued, true);
+
+    CallbackSlot* slot;
+    CallbackData* callbackData = callbackDataAcquire(&slot);
+
+    // VALUES ARE READ FROM THE CONTROL BLOCK WHEN THE ENTRY IS PROCESSED
+    callbackData->setStatistics(globalSessionId, 0, 0, 0, 0, 0, 0, 0);
+
+    callbackDataPublish(slot, callbackData);
+}
+
+/**
+ * Adds statistics data to the end of callback data queue. Updates of sessions with a control block
+ * are coalesced in the statistics snapshot of the block.
+ */
+static void statisticsCallbackDataAdd(int frameNumber, float fps, float quality, int64_t size, double time, double bitrate, double speed) {
+    SessionControl* sessionControl = globalSessionControl;
+
+    if (sessionControl != nullptr) {
+        statisticsSnapshotWrite(&sessionControl->statistics, frameNumber, fps, quality, size, time, bitrate, speed);
+        statisticsSnapshotQueue(sessionControl, false);
+        return;
+    }
+
+    CallbackSlot* slot;
+    CallbackData* callbackData = callbackDataAcquire(&slot);
+
+    callbackData->setStatistics(globalSessionId, frameNumber, fps, quality, size, time, bitrate, speed);
+
+    callbackDataPublish(slot, callbackData);
+}
+
+/**
+ * Removes head of the callback data overflow list.
+ */
+static CallbackData *callbackOverflowRemove() {
     std::unique_lock<std::recursive_mutex> lock(callbackDataMutex, std::defer_lock);
-    CallbackData* callbackData = new CallbackData(globalSessionId, level, data);
+    CallbackData* newData = nullptr;
 
     lock.lock();
-    callbackDataList.push_back(callbackData);
+    if (callbackOverflowList.size() > 0) {
+        newData = callbackOverflowList.front();
+        callbackOverflowList.pop_front();
+    }
     lock.unlock();
 
-    callbackNotify();
+    return newData;
+}
+
+/**
+ * Forwards a callback data entry to the log or statistics processor.
+ *
+ * @param callbackData callback data entry
+ */
+static void callbackDataProcess(CallbackData* callbackData);
+
+/**
+ * Finds the control block of a session.
+ *
+ * @param sessionId session id
+ * @return control block or nullptr if the session is not executing and has no messages in transmit
+ */
+static SessionControl* sessionControlFind(long sessionId) {
+    const int maxProbe = std::atomic_load(&sessionControlMaxProbe);
+
+    for (int i = 0; i <= maxProbe; i++) {
+        SessionControl* sessionControl = &sessionControlTable[(sessionId + i) & (SESSION_CONTROL_TABLE_SIZE - 1)];
+        if (std::atomic_load(&sessionControl->sessionId) == sessionId) {
+            return sessionControl;
+        }
+    }
 
-    std::atomic_fetch_add(&sessionInTransitMessageCountMap[globalSessionId % SESSION_MAP_SIZE], 1);
+    return nullptr;
 }
 
 /**
- * Adds statistics data to the end of callback data list.
+ * Drops a reference to a control block and frees its slot when no references are left.
+ *
+ * @param sessionControl control block
  */
-static void statisticsCallbackDataAdd(int frameNumber, float fps, float quality, int64_t size, int time, double bitrate, double speed) {
-    std::unique_lock<std::recursive_mutex> lock(callbackDataMutex, std::defer_lock);
-    CallbackData* callbackData = new CallbackData(globalSessionId, frameNumber, fps, quality, size, time, bitrate, speed);
-
-    lock.lock();
-    callbackDataList.push_back(callbackData);
-    lock.unlock();
-
-    callbackNotify();
-    
-    std::atomic_fetch_add(&sessionInTransitMessageCountMap[globalSessionId % SESSION_MAP_SIZE], 1);
+static void sessionControlRelease(SessionControl* sessionControl) {
+    if (std::atomic_fetch_sub(&sessionControl->references, 1) == 1) {
+        std::atomic_store(&sessionControl->sessionId, 0L);
+    }
 }
 
 /**
- * Removes head of callback data list.
+ * Resolves the log sinks of a session from its log callback and log redirection strategy. Logs of
+ * sessions that are not in the session history are only printed or forwarded to the global log
+ * callback, same as in process_log.
+ *
+ * @param session session or nullptr if the session is not found
+ * @return log sink mask
  */
-static CallbackData *callbackDataRemove() {
-    std::unique_lock<std::recursive_mutex> lock(callbackDataMutex, std::defer_lock);
-    CallbackData* newData = nullptr;
+static int logSinkMaskResolve(const std::shared_ptr<ffmpegkit::Session> session) {
+    ffmpegkit::LogRedirectionStrategy strategy = globalLogRedirectionStrategy;
+    bool sessionCallbackDefined = false;
 
-    lock.lock();
-    if (callbackDataList.size() > 0) {
-        newData = callbackDataList.front();
-        callbackDataList.pop_front();
+    if (session != nullptr) {
+        strategy = session->getLogRedirectionStrategy();
+        sessionCallbackDefined = (session->getLogCallback() != nullptr);
     }
-    lock.unlock();
 
-    return newData;
+    int mask = sessionCallbackDefined ? LOG_SINK_SESSION_CALLBACK : 0;
+    switch (strategy) {
+        case ffmpegkit::LogRedirectionStrategyNeverPrintLogs:
+            break;
+        case ffmpegkit::LogRedirectionStrategyPrintLogsWhenGlobalCallbackNotDefined:
+            mask |= LOG_SINK_PRINT_WITHOUT_GLOBAL_CALLBACK;
+            break;
+        case ffmpegkit::LogRedirectionStrategyPrintLogsWhenSessionCallbackNotDefined:
+            mask |= sessionCallbackDefined ? 0 : LOG_SINK_PRINT;
+            break;
+        case ffmpegkit::LogRedirectionStrategyPrintLogsWhenNoCallbacksDefined:
+            mask |= sessionCallbackDefined ? 0 : LOG_SINK_PRINT_WITHOUT_GLOBAL_CALLBACK;
+            break;
+        case ffmpegkit::LogRedirectionStrategyAlwaysPrintLogs:
+            mask |= LOG_SINK_PRINT;
+            break;
+    }
+
+    return mask;
 }
 
 /**
- * Registers a session id to the session map.
+ * Registers a session id to the session control table and makes its control block the control
+ * block of the current execution.
  *
  * @param sessionId session id
  */
 static void registerSessionId(long sessionId) {
-    std::atomic_store(&sessionMap[sessionId % SESSION_MAP_SIZE], (short)1);
+    const std::shared_ptr<ffmpegkit::Session> session = ffmpegkit::FFmpegKitConfig::getSession(sessionId);
+
+    globalSessionControl = nullptr;
+
+    for (int i = 0; i < SESSION_CONTROL_TABLE_SIZE; i++) {
+        SessionControl* sessionControl = &sessionControlTable[(sessionId + i) & (SESSION_CONTROL_TABLE_SIZE - 1)];
+        long freeSlot = 0;
+
+        if (std::atomic_compare_exchange_strong(&sessionControl->sessionId, &freeSlot, sessionId)) {
+            std::atomic_store(&sessionControl->references, 1);
+            std::atomic_store(&sessionControl->messagesInTransmit, 0);
+            std::atomic_store(&sessionControl->logSinkMask, logSinkMaskResolve(session));
+            std::atomic_store(&sessionControl->logStoreLevel, (session != nullptr) ? (int)session->getLogStoreLevel() : (int)ffmpegkit::LevelAVLogStdErr - 1);
+            statisticsSnapshotReset(&sessionControl->statistics);
+
+            int maxProbe = std::atomic_load(&sessionControlMaxProbe);
+            while (i > maxProbe && !std::atomic_compare_exchange_weak(&sessionControlMaxProbe, &maxProbe, i)) {
+            }
+
+            globalSessionControl = sessionControl;
+            return;
+        }
+    }
+
+    std::cout << "Session control table is full, session " << sessionId << " can not be cancelled." << std::endl;
 }
 
 /**
- * Removes a session id from the session map.
- *
- * @param sessionId session id
+ * Releases the control block of the current execution, registered by registerSessionId. The
+ * block stays in the session control table until all messages of the session are processed.
  */
-static void removeSession(long sessionId) {
-    std::atomic_store(&sessionMap[sessionId % SESSION_MAP_SIZE], (short)0);
+static void removeSession() {
+    SessionControl* sessionControl = globalSessionControl;
+
+    if (sessionControl != nullptr) {
+
+        // DELIVER THE LAST STATISTICS HELD BACK BY THE STATISTICS RATE
+        statisticsSnapshotQueue(sessionControl, true);
+    }
+
+    globalSessionControl = nullptr;
+    if (sessionControl != nullptr) {
+        sessionControlRelease(sessionControl);
+    }
 }
 
 #ifdef __cplusplus
@@ -429,22 +1216,33 @@ extern "C" {
 #endif
 
 /**
- * Adds a cancel session request to the session map.
+ * Adds a cancel session request to the session control table.
  *
  * @param sessionId session id
  */
 void cancelSession(long sessionId) {
-    std::atomic_store(&sessionMap[sessionId % SESSION_MAP_SIZE], (short)2);
+    SessionControl* sessionControl = sessionControlFind(sessionId);
+    if (sessionControl != nullptr) {
+        std::atomic_store(&sessionControl->cancelledSessionId, sessionId);
+    }
 }
 
 /**
- * Checks whether a cancel request for the given session id exists in the session map.
+ * Checks whether a cancel request for the given session id exists in the session control table.
+ *
+ * <p>Called from the transcode loop, for the current execution this is a single atomic load.
  *
  * @param sessionId session id
  * @return 1 if exists, false otherwise
  */
 int cancelRequested(long sessionId) {
-    if (std::atomic_load(&sessionMap[sessionId % SESSION_MAP_SIZE]) == 2) {
+    SessionControl* sessionControl = globalSessionControl;
+
+    if (sessionControl == nullptr || sessionId != globalSessionId) {
+        sessionControl = sessionControlFind(sessionId);
+    }
+
+    if (sessionControl != nullptr && std::atomic_load_explicit(&sessionControl->cancelledSessionId, std::memory_order_relaxed) == sessionId) {
         return 1;
     } else {
         return 0;
@@ -456,12 +1254,33 @@ int cancelRequested(long sessionId) {
 #endif
 
 /**
- * Resets the number of messages in transmit for this session.
+ * Checks whether a log line of the current execution is stored by its session, forwarded to a
+ * log callback or printed.
  *
- * @param sessionId session id
+ * @param level log level
+ * @return true if the log line has a consumer, false if it can be dropped
  */
-static void resetMessagesInTransmit(long sessionId) {
-    std::atomic_store(&sessionInTransitMessageCountMap[sessionId % SESSION_MAP_SIZE], 0);
+static bool logLineWanted(int level) {
+    SessionControl* sessionControl = globalSessionControl;
+
+    // DECODER, ENCODER AND FILTER THREADS ONLY KNOW THE SESSION ID
+    if (sessionControl == nullptr && globalSessionId != 0) {
+        sessionControl = sessionControlFind(globalSessionId);
+    }
+    if (sessionControl == nullptr) {
+        return true;
+    }
+
+    if (level <= std::atomic_load_explicit(&sessionControl->logStoreLevel, std::memory_order_relaxed)) {
+        return true;
+    }
+
+    const int mask = std::atomic_load_explicit(&sessionControl->logSinkMask, std::memory_order_relaxed);
+    if (mask & (LOG_SINK_SESSION_CALLBACK | LOG_SINK_PRINT)) {
+        return true;
+    }
+
+    return std::atomic_load_explicit(&logCallbackDefined, std::memory_order_relaxed) || (mask & LOG_SINK_PRINT_WITHOUT_GLOBAL_CALLBACK);
 }
 
 /**
@@ -473,9 +1292,6 @@ static void resetMessagesInTransmit(long sessionId) {
  * @param vargs arguments
  */
 void ffmpegkit_log_callback_function(void *ptr, int level, const char* format, va_list vargs) {
-    AVBPrint fullLine;
-    AVBPrint part[4];
-    int print_prefix = 1;
 
     // DO NOT PROCESS UNWANTED LOGS
     if (level >= 0) {
@@ -488,26 +1304,12 @@ void ffmpegkit_log_callback_function(void *ptr, int level, const char* format, v
         return;
     }
 
-    av_bprint_init(&fullLine, 0, AV_BPRINT_SIZE_UNLIMITED);
-
-    avutil_log_format_line(ptr, level, format, vargs, part, &print_prefix);
-    avutil_log_sanitize(part[0].str);
-    avutil_log_sanitize(part[1].str);
-    avutil_log_sanitize(part[2].str);
-    avutil_log_sanitize(part[3].str);
-
-    // COMBINE ALL 4 LOG PARTS
-    av_bprintf(&fullLine, "%s%s%s%s", part[0].str, part[1].str, part[2].str, part[3].str);
-
-    if (fullLine.len > 0) {
-        logCallbackDataAdd(level, &fullLine);
+    // DO NOT FORMAT LOGS THAT ARE NEITHER STORED, FORWARDED NOR PRINTED
+    if (!logLineWanted(level)) {
+        return;
     }
 
-    av_bprint_finalize(part, NULL);
-    av_bprint_finalize(part+1, NULL);
-    av_bprint_finalize(part+2, NULL);
-    av_bprint_finalize(part+3, NULL);
-    av_bprint_finalize(&fullLine, NULL);
+    logCallbackDataAdd(ptr, level, format, vargs);
 }
 
 /**
@@ -525,10 +1327,42 @@ void ffmpegkit_statistics_callback_function(int frameNumber, float fps, float qu
     statisticsCallbackDataAdd(frameNumber, fps, quality, size, time, bitrate, speed);
 }
 
-static void process_log(long sessionId, int levelValueInt, AVBPrint* logMessage) {
+/**
+ * Callback function for FFmpeg stream statistics. Called on the session thread right before the
+ * statistics callback, the list is delivered with the statistics entry that follows.
+ *
+ * @param reports reports of the input streams followed by the reports of the output streams
+ * @param nbReports number of reports
+ */
+void ffmpegkit_stream_statistics_callback_function(const StreamReport* reports, int nbReports) {
+    SessionControl* sessionControl = globalSessionControl;
+
+    if (sessionControl == nullptr) {
+        return;
+    }
+
+    std::shared_ptr<StreamStatisticsList> streams = std::make_shared<StreamStatisticsList>();
+    for (int i = 0; i < nbReports; i++) {
+        const StreamReport* report = &reports[i];
+        const char* type = av_get_media_type_string(report->type);
+
+        streams->push_back(std::make_shared<ffmpegkit::StreamStatistics>(report->file_index, report->index, report->output != 0, (type != NULL) ? type : "unknown",
+                                                                          report->packets_demuxed, report->frames_decoded, report->frames_filtered,
+                                                                          report->frames_encoded, report->packets_encoded, report->packets_muxed,
+                                                                          report->frames_dup, report->frames_drop, report->queue_depth,
+                                                                          report->decode_wall_time, report->decode_cpu_time,
+                                                                          report->filter_wall_time, report->filter_cpu_time,
+                                                                          report->encode_wall_time, report->encode_cpu_time,
+                                                                          report->mux_wall_time, report->mux_cpu_time));
+    }
+
+    std::atomic_store(&sessionControl->statistics.streams, streams);
+}
+
+static void process_log(long sessionId, int levelValueInt, const char* logMessage) {
     int activeLogLevel = av_log_get_level();
     ffmpegkit::Level levelValue = static_cast<ffmpegkit::Level>(levelValueInt);
-    std::shared_ptr<ffmpegkit::Log> log = std::make_shared<ffmpegkit::Log>(sessionId, levelValue, logMessage->str);
+    std::shared_ptr<ffmpegkit::Log> log = std::make_shared<ffmpegkit::Log>(sessionId, levelValue, logMessage);
     bool globalCallbackDefined = false;
     bool sessionCallbackDefined = false;
     ffmpegkit::LogRedirectionStrategy activeLogRedirectionStrategy = globalLogRedirectionStrategy;
@@ -542,7 +1376,9 @@ static void process_log(long sessionId, int levelValueInt, AVBPrint* logMessage)
     auto session = ffmpegkit::FFmpegKitConfig::getSession(sessionId);
     if (session != nullptr) {
         activeLogRedirectionStrategy = session->getLogRedirectionStrategy();
-        session->addLog(log);
+        if (levelValue <= session->getLogStoreLevel()) {
+            session->addLog(log);
+        }
 
         ffmpegkit::LogCallback sessionLogCallback = session->getLogCallback();
         if (sessionLogCallback != nullptr) {
@@ -604,13 +1440,14 @@ static void process_log(long sessionId, int levelValueInt, AVBPrint* logMessage)
             break;
         default:
             // WRITE TO STDOUT
-            std::cout << ffmpegkit::FFmpegKitConfig::logLevelToString(levelValue) << ": " << logMessage->str;
+            std::cout << ffmpegkit::FFmpegKitConfig::logLevelToString(levelValue) << ": " << logMessage;
             break;
     }
 }
 
-void process_statistics(long sessionId, int videoFrameNumber, float videoFps, float videoQuality, long size, double time, double bitrate, double speed) {
+void process_statistics(long sessionId, int videoFrameNumber, float videoFps, float videoQuality, long size, double time, double bitrate, double speed, const std::shared_ptr<StreamStatisticsList> streams) {
     std::shared_ptr<ffmpegkit::Statistics> statistics = std::make_shared<ffmpegkit::Statistics>(sessionId, videoFrameNumber, videoFps, videoQuality, size, time, bitrate, speed);
+    statistics->setStreamStatistics(streams);
 
     auto session = ffmpegkit::FFmpegKitConfig::getSession(sessionId);
     if (session != nullptr && session->isFFmpeg()) {
@@ -635,6 +1472,101 @@ void process_statistics(long sessionId, int videoFrameNumber, float videoFps, fl
             std::cout << "Exception thrown inside global statistics callback. " << exception.what() << std::endl;
         }
     }
+
+    ffmpegkit::StreamStatisticsCallback globalStreamStatisticsCallback = streamStatisticsCallback;
+    if (streams != nullptr && globalStreamStatisticsCallback != nullptr) {
+        try {
+            globalStreamStatisticsCallback(sessionId, streams);
+        } catch(const std::exception& exception) {
+            std::cout << "Exception thrown inside global stream statistics callback. " << exception.what() << std::endl;
+        }
+    }
+}
+
+/**
+ * Delivers the latest statistics of a session. Skips the delivery when the values were already
+ * delivered by a previous entry.
+ *
+ * @param sessionId session id
+ * @param snapshot statistics snapshot of the session
+ */
+static void statisticsSnapshotProcess(long sessionId, StatisticsSnapshot* snapshot) {
+    unsigned sequence;
+    int videoFrameNumber;
+    float videoFps;
+    float videoQuality;
+    int64_t size;
+    double time;
+    double bitrate;
+    double speed;
+
+    // UPDATES RECEIVED FROM NOW ON NEED A NEW ENTRY
+    std::atomic_store(&snapshot->queued, false);
+
+    // ORDERS THE QUEUED STORE BEFORE THE SEQUENCE LOAD, PAIRED WITH THE FENCE IN statisticsSnapshotQueue
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    for (;;) {
+        sequence = snapshot->sequence.load(std::memory_order_acquire);
+        if (sequence & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        videoFrameNumber = snapshot->videoFrameNumber.load(std::memory_order_relaxed);
+        videoFps = snapshot->videoFps.load(std::memory_order_relaxed);
+        videoQuality = snapshot->videoQuality.load(std::memory_order_relaxed);
+        size = snapshot->size.load(std::memory_order_relaxed);
+        time = snapshot->time.load(std::memory_order_relaxed);
+        bitrate = snapshot->bitrate.load(std::memory_order_relaxed);
+        speed = snapshot->speed.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (snapshot->sequence.load(std::memory_order_relaxed) == sequence) {
+            break;
+        }
+    }
+
+    if (sequence == std::atomic_load(&snapshot->delivered)) {
+        return;
+    }
+    std::atomic_store(&snapshot->delivered, sequence);
+
+    process_statistics(sessionId, videoFrameNumber, videoFps, videoQuality, size, time, bitrate, speed, std::atomic_load(&snapshot->streams));
+}
+
+static void callbackDataProcess(CallbackData* callbackData) {
+    SessionControl* sessionControl = callbackData->getSessionControl();
+
+    if (callbackData->getType() == LogType) {
+
+        // EMPTY LINES ARE QUEUED BECAUSE THE LENGTH IS ONLY KNOWN AFTER THE ENTRY IS CLAIMED
+        if (callbackData->getLogLength() > 0) {
+            process_log(callbackData->getSessionId(), callbackData->getLogLevel(), callbackData->getLogData());
+        }
+    } else if (sessionControl != nullptr) {
+        statisticsSnapshotProcess(callbackData->getSessionId(), &sessionControl->statistics);
+    } else {
+        process_statistics(callbackData->getSessionId(),
+                           callbackData->getStatisticsFrameNumber(),
+                           callbackData->getStatisticsFps(),
+                           callbackData->getStatisticsQuality(),
+                           callbackData->getStatisticsSize(),
+                           callbackData->getStatisticsTime(),
+                           callbackData->getStatisticsBitrate(),
+                           callbackData->getStatisticsSpeed(),
+                           nullptr);
+    }
+
+    if (sessionControl != nullptr) {
+        if (std::atomic_fetch_sub(&sessionControl->messagesInTransmit, 1) == 1) {
+
+            // WAKE UP THREADS WAITING FOR THIS SESSION TO DRAIN
+            std::unique_lock<std::mutex> lock(messagesInTransmitMutex);
+            messagesInTransmitMonitor.notify_all();
+        }
+        sessionControlRelease(sessionControl);
+    }
 }
 
 /**
@@ -648,28 +1580,28 @@ void *callbackThreadFunction(void *pointer) {
 
     while(redirectionEnabled) {
         try {
-            CallbackData* callbackData = callbackDataRemove();
+            CallbackData* callbackData = callbackRingPeek();
 
             if (callbackData != nullptr) {
-
-                if (callbackData->getType() == LogType) {
-                    process_log(callbackData->getSessionId(), callbackData->getLogLevel(), callbackData->getLogData());
-                    av_bprint_finalize(callbackData->getLogData(), NULL);
-                } else {
-                    process_statistics(callbackData->getSessionId(),
-                                       callbackData->getStatisticsFrameNumber(),
-                                       callbackData->getStatisticsFps(),
-                                       callbackData->getStatisticsQuality(),
-                                       callbackData->getStatisticsSize(),
-                                       callbackData->getStatisticsTime(),
-                                       callbackData->getStatisticsBitrate(),
-                                       callbackData->getStatisticsSpeed());
+                try {
+                    callbackDataProcess(callbackData);
+                } catch(const std::exception& exception) {
+                    callbackRingRelease();
+                    throw;
+                }
+                callbackRingRelease();
+            } else if (std::atomic_load(&callbackOverflowCount) > 0 && callbackRingEmpty()) {
+
+                // RING IS DRAINED, OVERFLOW ENTRIES CAN BE PROCESSED WITHOUT BREAKING THE ORDER. A HEAD
+                // SLOT THAT IS CLAIMED BUT NOT PUBLISHED YET MAY HAVE ENTRIES OF THE SAME THREADS BEHIND IT
+                callbackData = callbackOverflowRemove();
+                if (callbackData != nullptr) {
+                    std::atomic_fetch_sub(&callbackOverflowCount, 1);
+                    std::unique_ptr<CallbackData> callbackDataHolder(callbackData);
+                    callbackDataProcess(callbackData);
                 }
-
-                std::atomic_fetch_sub(&sessionInTransitMessageCountMap[callbackData->getSessionId() % SESSION_MAP_SIZE], 1);
-
             } else {
-                callbackWait(100);
+                callbackWait();
             }
 
         } catch(const std::exception& exception) {
@@ -713,13 +1645,11 @@ static int executeFFmpeg(const long sessionId, const std::shared_ptr<std::list<s
     globalSessionId = sessionId;
     registerSessionId(sessionId);
 
-    resetMessagesInTransmit(sessionId);
-
     // RUN
     int returnCode = ffmpeg_execute((arguments->size() + 1), commandCharPArray);
 
     // ALWAYS REMOVE THE ID FROM THE MAP
-    removeSession(sessionId);
+    removeSession();
 
     // CLEANUP
     av_free(commandCharPArray[0]);
@@ -728,7 +1658,7 @@ static int executeFFmpeg(const long sessionId, const std::shared_ptr<std::list<s
     return returnCode;
 }
 
-int executeFFprobe(const long sessionId, const std::shared_ptr<std::list<std::string>> arguments) {
+int executeFFprobe(const long sessionId, const std::shared_ptr<std::list<std::string>> arguments, AVBPrint* outputBuffer) {
     const char* LIB_NAME = "ffprobe";
 
     // SETS DEFAULT LOG LEVEL BEFORE STARTING A NEW RUN
@@ -753,13 +1683,15 @@ int executeFFprobe(const long sessionId, const std::shared_ptr<std::list<std::st
     globalSessionId = sessionId;
     registerSessionId(sessionId);
 
-    resetMessagesInTransmit(sessionId);
+    set_ffprobe_output_buffer(outputBuffer);
 
     // RUN
     int returnCode = ffprobe_execute((arguments->size() + 1), commandCharPArray);
 
+    set_ffprobe_output_buffer(NULL);
+
     // ALWAYS REMOVE THE ID FROM THE MAP
-    removeSession(sessionId);
+    removeSession();
     
     // CLEANUP
     av_free(commandCharPArray[0]);
@@ -768,17 +1700,180 @@ int executeFFprobe(const long sessionId, const std::shared_ptr<std::list<std::st
     return returnCode;
 }
 
+int executeFFprobe(const long sessionId, const std::shared_ptr<std::list<std::string>> arguments) {
+    return executeFFprobe(sessionId, arguments, NULL);
+}
+
+/**
+ * Checks whether the given arguments only request the properties MediaInformationNativeParser can
+ * extract, which is the case for arguments created by FFprobeKit::getMediaInformation methods.
+ *
+ * @param arguments ffprobe arguments
+ * @param path set to the input path when arguments are supported
+ * @param logLevel set to the log level requested using -v or -loglevel, left unchanged otherwise
+ * @return true if media information can be extracted without running ffprobe, false otherwise
+ */
+static bool mediaInformationNativeArguments(const std::shared_ptr<std::list<std::string>> arguments, std::string& path, int& logLevel) {
+    static const struct {
+        const char* name;
+        int level;
+    } logLevels[] = {
+        { "quiet",   AV_LOG_QUIET   },
+        { "panic",   AV_LOG_PANIC   },
+        { "fatal",   AV_LOG_FATAL   },
+        { "error",   AV_LOG_ERROR   },
+        { "warning", AV_LOG_WARNING },
+        { "info",    AV_LOG_INFO    },
+        { "verbose", AV_LOG_VERBOSE },
+        { "debug",   AV_LOG_DEBUG   },
+        { "trace",   AV_LOG_TRACE   }
+    };
+    bool showFormat = false;
+    bool showStreams = false;
+    bool showChapters = false;
+    bool jsonFormat = false;
+    bool inputFound = false;
+
+    for (auto it = arguments->begin(); it != arguments->end(); it++) {
+        const std::string& argument = *it;
+
+        if (argument == "-hide_banner") {
+            continue;
+        } else if (argument == "-show_format") {
+            showFormat = true;
+        } else if (argument == "-show_streams") {
+            showStreams = true;
+        } else if (argument == "-show_chapters") {
+            showChapters = true;
+        } else if (std::next(it) == arguments->end()) {
+            return false;
+        } else if (argument == "-print_format" || argument == "-of") {
+            jsonFormat = (*(++it) == "json");
+        } else if (argument == "-v" || argument == "-loglevel") {
+            const std::string& level = *(++it);
+            bool levelFound = false;
+            for (const auto& logLevelEntry : logLevels) {
+                if (level == logLevelEntry.name) {
+                    logLevel = logLevelEntry.level;
+                    levelFound = true;
+                }
+            }
+            if (!levelFound) {
+                return false;
+            }
+        } else if (argument == "-i" && !inputFound) {
+            path = *(++it);
+            inputFound = true;
+        } else {
+            return false;
+        }
+    }
+
+    return showFormat && showStreams && showChapters && jsonFormat && inputFound;
+}
+
+/**
+ * Interrupt callback used to stop opening and probing an input when its session is cancelled.
+ *
+ * @param opaque pointer to the session id
+ * @return 1 if cancel is requested, 0 otherwise
+ */
+static int mediaInformationInterruptCallback(void* opaque) {
+    return cancelRequested(*static_cast<long*>(opaque));
+}
+
+/**
+ * Prints an input error the same way ffprobe prints it.
+ *
+ * @param path input path
+ * @param error error code
+ */
+static void mediaInformationPrintError(const std::string& path, const int error) {
+    char errorBuffer[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(error, errorBuffer, sizeof(errorBuffer));
+    av_log(NULL, AV_LOG_ERROR, "%s: %s\n", path.c_str(), errorBuffer);
+}
+
+/**
+ * Opens the input in-process and extracts its media information without running ffprobe.
+ *
+ * @param sessionId session id
+ * @param path input path
+ * @param logLevel log level to use during probing
+ * @param mediaInformation set to the extracted media information on success
+ * @return return code, same as the one ffprobe would return
+ */
+static int executeMediaInformationProbe(long sessionId, const std::string& path, const int logLevel, std::shared_ptr<ffmpegkit::MediaInformation>& mediaInformation) {
+    AVFormatContext* formatContext = avformat_alloc_context();
+    AVDictionary* formatOptions = NULL;
+    int returnCode = 0;
+    int error;
+
+    av_log_set_level(logLevel);
+
+    // REGISTER THE ID BEFORE STARTING THE SESSION
+    globalSessionId = sessionId;
+    registerSessionId(sessionId);
+
+    if (formatContext == NULL) {
+        mediaInformationPrintError(path, AVERROR(ENOMEM));
+        removeSession();
+        return 1;
+    }
+
+    formatContext->interrupt_callback.callback = mediaInformationInterruptCallback;
+    formatContext->interrupt_callback.opaque = &sessionId;
+
+    // SAME AS FFPROBE
+    av_dict_set(&formatOptions, "scan_all_pmts", "1", AV_DICT_DONT_OVERWRITE);
+
+    // RUN
+    if ((error = avformat_open_input(&formatContext, path.c_str(), NULL, &formatOptions)) < 0) {
+        mediaInformationPrintError(path, error);
+        returnCode = 1;
+    } else if ((error = avformat_find_stream_info(formatContext, NULL)) < 0) {
+        mediaInformationPrintError(path, error);
+        returnCode = 1;
+    } else if (!cancelRequested(sessionId)) {
+        mediaInformation = ffmpegkit::MediaInformationNativeParser::from(formatContext);
+    }
+
+    if (cancelRequested(sessionId)) {
+        mediaInformation = nullptr;
+        returnCode = 255;
+    }
+
+    // ALWAYS REMOVE THE ID FROM THE MAP
+    removeSession();
+
+    // CLEANUP
+    avformat_close_input(&formatContext);
+    av_dict_free(&formatOptions);
+
+    return returnCode;
+}
+
 void* ffmpegKitInitialize() {
     std::call_once(ffmpegKitInitializerFlag, [](){
         std::cout << "Loading ffmpeg-kit." << std::endl;
 
         sessionHistorySize = 10;
 
-        for(int i = 0; i<SESSION_MAP_SIZE; i++) {
-            std::atomic_init(&sessionMap[i], (short)0);
-            std::atomic_init(&sessionInTransitMessageCountMap[i], 0);
+        const int availableProcessors = std::max(1, (int)std::thread::hardware_concurrency());
+        ffmpegAsyncExecutor = new AsyncExecutor(availableProcessors);
+        ffprobeAsyncExecutor = new AsyncExecutor(availableProcessors);
+
+        for(int i = 0; i<SESSION_CONTROL_TABLE_SIZE; i++) {
+            std::atomic_init(&sessionControlTable[i].sessionId, 0L);
+            std::atomic_init(&sessionControlTable[i].cancelledSessionId, 0L);
+            std::atomic_init(&sessionControlTable[i].references, 0);
+            std::atomic_init(&sessionControlTable[i].messagesInTransmit, 0);
+            std::atomic_init(&sessionControlTable[i].logSinkMask, 0);
+            std::atomic_init(&sessionControlTable[i].logStoreLevel, 0);
         }
 
+        callbackRingInit();
+
         logCallback = nullptr;
         statisticsCallback = nullptr;
         ffmpegSessionCompleteCallback = nullptr;
@@ -1009,11 +2104,58 @@ void ffmpegkit::FFmpegKitConfig::ignoreSignal(const ffmpegkit::Signal signal) {
     }
 }
 
-void ffmpegkit::FFmpegKitConfig::ffmpegExecute(const std::shared_ptr<ffmpegkit::FFmpegSession> ffmpegSession) {
+/**
+ * Returns a copy of the given FFmpeg arguments that limits the number of threads used by decoders
+ * and filter graphs. Encoder thread options can't be injected without parsing output options, so
+ * encoders are not limited. The injected filter thread options set thread local globals, which
+ * ffmpeg_var_cleanup() resets before the next session on the same thread parses its options, so
+ * a later session that is not throttled uses the default thread counts again.
+ *
+ * @param arguments FFmpeg arguments
+ * @param threadCount number of threads
+ * @return throttled arguments
+ */
+static std::shared_ptr<std::list<std::string>> throttleFFmpegArguments(const std::shared_ptr<std::list<std::string>> arguments, const int threadCount) {
+    auto throttledArguments = std::make_shared<std::list<std::string>>();
+    const std::string threadCountString = std::to_string(threadCount);
+
+    throttledArguments->push_back("-filter_threads");
+    throttledArguments->push_back(threadCountString);
+    throttledArguments->push_back("-filter_complex_threads");
+    throttledArguments->push_back(threadCountString);
+
+    for (auto it = arguments->begin(); it != arguments->end(); it++) {
+        if (*it == "-i") {
+            throttledArguments->push_back("-threads");
+            throttledArguments->push_back(threadCountString);
+        }
+        throttledArguments->push_back(*it);
+    }
+
+    return throttledArguments;
+}
+
+/**
+ * Executes an FFmpeg session using the given arguments instead of session arguments.
+ *
+ * @param ffmpegSession FFmpeg session
+ * @param arguments FFmpeg arguments
+ */
+static void ffmpegExecuteWithArguments(const std::shared_ptr<ffmpegkit::FFmpegSession> ffmpegSession, const std::shared_ptr<std::list<std::string>> arguments) {
+    const std::string traceFile = ffmpegSession->getTraceFile();
+    std::shared_ptr<std::list<std::string>> executeArguments = arguments;
+
+    // TRACING IS A GLOBAL OPTION, IT IS INJECTED WITHOUT CHANGING SESSION ARGUMENTS
+    if (!traceFile.empty()) {
+        executeArguments = std::make_shared<std::list<std::string>>(*arguments);
+        executeArguments->push_front(traceFile);
+        executeArguments->push_front("-trace_file");
+    }
+
     ffmpegSession->startRunning();
     
     try {
-        int returnCode = executeFFmpeg(ffmpegSession->getSessionId(), ffmpegSession->getArguments());
+        int returnCode = executeFFmpeg(ffmpegSession->getSessionId(), executeArguments);
         ffmpegSession->complete(std::make_shared<ffmpegkit::ReturnCode>(returnCode));
     } catch(const std::exception& exception) {
         ffmpegSession->fail(exception.what());
@@ -1021,6 +2163,10 @@ void ffmpegkit::FFmpegKitConfig::ffmpegExecute(const std::shared_ptr<ffmpegkit::
     }
 }
 
+void ffmpegkit::FFmpegKitConfig::ffmpegExecute(const std::shared_ptr<ffmpegkit::FFmpegSession> ffmpegSession) {
+    ffmpegExecuteWithArguments(ffmpegSession, ffmpegSession->getArguments());
+}
+
 void ffmpegkit::FFmpegKitConfig::ffprobeExecute(const std::shared_ptr<ffmpegkit::FFprobeSession> ffprobeSession) {
     ffprobeSession->startRunning();
     
@@ -1033,33 +2179,67 @@ void ffmpegkit::FFmpegKitConfig::ffprobeExecute(const std::shared_ptr<ffmpegkit:
     }
 }
 
-void ffmpegkit::FFmpegKitConfig::getMediaInformationExecute(const std::shared_ptr<ffmpegkit::MediaInformationSession> mediaInformationSession, const int waitTimeout) {
+void ffmpegkit::FFmpegKitConfig::getMediaInformationExecute(const std::shared_ptr<ffmpegkit::MediaInformationSession> mediaInformationSession, const int /* waitTimeout */) {
+    AVBPrint ffprobeJsonOutput;
+    std::string path;
+    int logLevel = configuredLogLevel;
+
     mediaInformationSession->startRunning();
-    
+
+    // DEFAULT ARGUMENTS ARE HANDLED IN-PROCESS WITHOUT PRODUCING AND PARSING JSON
+    if (mediaInformationNativeArguments(mediaInformationSession->getArguments(), path, logLevel)) {
+        try {
+            std::shared_ptr<ffmpegkit::MediaInformation> mediaInformation = ffmpegkit::MediaInformationCache::get(path);
+            if (mediaInformation != nullptr) {
+                mediaInformationSession->complete(std::make_shared<ffmpegkit::ReturnCode>(static_cast<int>(ffmpegkit::ReturnCode::Success)));
+                mediaInformationSession->setMediaInformation(mediaInformation);
+                return;
+            }
+
+            int returnCodeValue = executeMediaInformationProbe(mediaInformationSession->getSessionId(), path, logLevel, mediaInformation);
+            mediaInformationSession->complete(std::make_shared<ffmpegkit::ReturnCode>(returnCodeValue));
+            if (mediaInformation != nullptr) {
+                mediaInformationSession->setMediaInformation(mediaInformation);
+                ffmpegkit::MediaInformationCache::put(path, mediaInformation);
+            }
+        } catch(const std::exception& exception) {
+            mediaInformationSession->fail(exception.what());
+            std::cout << "Get media information execute failed: " << ffmpegkit::FFmpegKitConfig::argumentsToString(mediaInformationSession->getArguments()) << "." << exception.what() << std::endl;
+        }
+        return;
+    }
+
+    // FFPROBE OUTPUT IS WRITTEN DIRECTLY INTO THIS BUFFER INSTEAD OF BEING SENT THROUGH THE LOG CALLBACK
+    av_bprint_init(&ffprobeJsonOutput, 0, AV_BPRINT_SIZE_UNLIMITED);
+
     try {
-        int returnCodeValue = executeFFprobe(mediaInformationSession->getSessionId(), mediaInformationSession->getArguments());
+        int returnCodeValue = executeFFprobe(mediaInformationSession->getSessionId(), mediaInformationSession->getArguments(), &ffprobeJsonOutput);
         auto returnCode = std::make_shared<ffmpegkit::ReturnCode>(returnCodeValue);
         mediaInformationSession->complete(returnCode);
         if (returnCode->isValueSuccess()) {
-            auto allLogs = mediaInformationSession->getAllLogsWithTimeout(waitTimeout);
-            std::string ffprobeJsonOutput;
-            std::for_each(allLogs->cbegin(), allLogs->cend(), [&](std::shared_ptr<ffmpegkit::Log> log) {
-                if (log->getLevel() == LevelAVLogStdErr) {
-                    ffprobeJsonOutput.append(log->getMessage());
-                }
-            });
-            auto mediaInformation = ffmpegkit::MediaInformationJsonParser::fromWithError(ffprobeJsonOutput.c_str());
+            if (!av_bprint_is_complete(&ffprobeJsonOutput)) {
+                throw std::runtime_error("Failed to allocate memory for ffprobe output.");
+            }
+            auto mediaInformation = ffmpegkit::MediaInformationJsonParser::fromWithError(std::string(ffprobeJsonOutput.str, ffprobeJsonOutput.len));
             mediaInformationSession->setMediaInformation(mediaInformation);
         }
     } catch(const std::exception& exception) {
         mediaInformationSession->fail(exception.what());
         std::cout << "Get media information execute failed: " << ffmpegkit::FFmpegKitConfig::argumentsToString(mediaInformationSession->getArguments()) << "." << exception.what() << std::endl;
     }
+
+    av_bprint_finalize(&ffprobeJsonOutput, NULL);
 }
 
 void ffmpegkit::FFmpegKitConfig::asyncFFmpegExecute(const std::shared_ptr<ffmpegkit::FFmpegSession> ffmpegSession) {
-    auto thread = std::thread([ffmpegSession]() {
-        ffmpegkit::FFmpegKitConfig::ffmpegExecute(ffmpegSession);
+    ffmpegAsyncExecutor->submit(ffmpegSession, [ffmpegSession](bool cancelled, bool throttled) {
+        if (cancelled) {
+            completeQueuedSessionAsCancelled(ffmpegSession);
+        } else if (throttled) {
+            ffmpegExecuteWithArguments(ffmpegSession, throttleFFmpegArguments(ffmpegSession->getArguments(), ffmpegSession->getSchedulingOptions().getThrottledThreadCount()));
+        } else {
+            ffmpegkit::FFmpegKitConfig::ffmpegExecute(ffmpegSession);
+        }
 
         ffmpegkit::FFmpegSessionCompleteCallback completeCallback = ffmpegSession->getCompleteCallback();
         if (completeCallback != nullptr) {
@@ -1081,13 +2261,15 @@ void ffmpegkit::FFmpegKitConfig::asyncFFmpegExecute(const std::shared_ptr<ffmpeg
             }
         }
     });
-
-    thread.detach();
 }
 
 void ffmpegkit::FFmpegKitConfig::asyncFFprobeExecute(const std::shared_ptr<ffmpegkit::FFprobeSession> ffprobeSession) {
-    auto thread = std::thread([ffprobeSession]() {
-        ffmpegkit::FFmpegKitConfig::ffprobeExecute(ffprobeSession);
+    ffprobeAsyncExecutor->submit(ffprobeSession, [ffprobeSession](bool cancelled, bool) {
+        if (cancelled) {
+            completeQueuedSessionAsCancelled(ffprobeSession);
+        } else {
+            ffmpegkit::FFmpegKitConfig::ffprobeExecute(ffprobeSession);
+        }
 
         ffmpegkit::FFprobeSessionCompleteCallback completeCallback = ffprobeSession->getCompleteCallback();
         if (completeCallback != nullptr) {
@@ -1109,13 +2291,15 @@ void ffmpegkit::FFmpegKitConfig::asyncFFprobeExecute(const std::shared_ptr<ffmpe
             }
         }
     });
-
-    thread.detach();
 }
 
 void ffmpegkit::FFmpegKitConfig::asyncGetMediaInformationExecute(const std::shared_ptr<ffmpegkit::MediaInformationSession> mediaInformationSession, const int waitTimeout) {
-    auto thread = std::thread([mediaInformationSession,waitTimeout]() {
-        ffmpegkit::FFmpegKitConfig::getMediaInformationExecute(mediaInformationSession, waitTimeout);
+    ffprobeAsyncExecutor->submit(mediaInformationSession, [mediaInformationSession,waitTimeout](bool cancelled, bool) {
+        if (cancelled) {
+            completeQueuedSessionAsCancelled(mediaInformationSession);
+        } else {
+            ffmpegkit::FFmpegKitConfig::getMediaInformationExecute(mediaInformationSession, waitTimeout);
+        }
 
         ffmpegkit::MediaInformationSessionCompleteCallback completeCallback = mediaInformationSession->getCompleteCallback();
         if (completeCallback != nullptr) {
@@ -1137,18 +2321,21 @@ void ffmpegkit::FFmpegKitConfig::asyncGetMediaInformationExecute(const std::shar
             }
         }
     });
-
-    thread.detach();
 }
 
 void ffmpegkit::FFmpegKitConfig::enableLogCallback(const ffmpegkit::LogCallback callback) {
     logCallback = callback;
+    std::atomic_store(&logCallbackDefined, callback != nullptr);
 }
 
 void ffmpegkit::FFmpegKitConfig::enableStatisticsCallback(const ffmpegkit::StatisticsCallback callback) {
     statisticsCallback = callback;
 }
 
+void ffmpegkit::FFmpegKitConfig::enableStreamStatisticsCallback(const ffmpegkit::StreamStatisticsCallback callback) {
+    streamStatisticsCallback = callback;
+}
+
 void ffmpegkit::FFmpegKitConfig::enableFFmpegSessionCompleteCallback(const FFmpegSessionCompleteCallback completeCallback) {
     ffmpegSessionCompleteCallback = completeCallback;
 }
@@ -1202,18 +2389,69 @@ int ffmpegkit::FFmpegKitConfig::getSessionHistorySize() {
 }
 
 void ffmpegkit::FFmpegKitConfig::setSessionHistorySize(const int newSessionHistorySize) {
-    if (newSessionHistorySize >= SESSION_MAP_SIZE) {
-
-        /*
-         * THERE IS A HARD LIMIT ON THE NATIVE SIDE. HISTORY SIZE MUST BE SMALLER THAN SESSION_MAP_SIZE
-         */
-        throw std::runtime_error("Session history size must not exceed the hard limit!");
-    } else if (newSessionHistorySize > 0) {
+    if (newSessionHistorySize > 0) {
         sessionHistorySize = newSessionHistorySize;
         deleteExpiredSessions();
     }
 }
 
+void ffmpegkit::FFmpegKitConfig::setLogRetention(const int lineLimit, const long byteLimit) {
+    logRetentionLineLimit = std::max(lineLimit, 0);
+    logRetentionByteLimit = std::max(byteLimit, 0L);
+}
+
+int ffmpegkit::FFmpegKitConfig::getLogRetentionLineLimit() {
+    return logRetentionLineLimit;
+}
+
+long ffmpegkit::FFmpegKitConfig::getLogRetentionByteLimit() {
+    return logRetentionByteLimit;
+}
+
+void ffmpegkit::FFmpegKitConfig::setStatisticsRetention(const int entryLimit) {
+    statisticsRetention = std::max(entryLimit, 0);
+}
+
+int ffmpegkit::FFmpegKitConfig::getStatisticsRetention() {
+    return statisticsRetention;
+}
+
+void ffmpegkit::FFmpegKitConfig::setStatisticsMaxRate(const int maxRate) {
+    statisticsMaxRate = std::max(maxRate, 0);
+}
+
+int ffmpegkit::FFmpegKitConfig::getStatisticsMaxRate() {
+    return statisticsMaxRate;
+}
+
+void ffmpegkit::FFmpegKitConfig::enableStreamStatistics() {
+    set_stream_report_callback(ffmpegkit_stream_statistics_callback_function);
+}
+
+void ffmpegkit::FFmpegKitConfig::disableStreamStatistics() {
+    set_stream_report_callback(NULL);
+}
+
+int ffmpegkit::FFmpegKitConfig::getAsyncConcurrencyLimit() {
+    return ffmpegAsyncExecutor->getConcurrencyLimit();
+}
+
+void ffmpegkit::FFmpegKitConfig::setAsyncConcurrencyLimit(const int asyncConcurrencyLimit) {
+    if (asyncConcurrencyLimit > 0) {
+        ffmpegAsyncExecutor->setConcurrencyLimit(asyncConcurrencyLimit);
+    }
+}
+
+int ffmpegkit::FFmpegKitConfig::getAsyncFFprobeConcurrencyLimit() {
+    return ffprobeAsyncExecutor->getConcurrencyLimit();
+}
+
+void ffmpegkit::FFmpegKitConfig::setAsyncFFprobeConcurrencyLimit(const int asyncConcurrencyLimit) {
+    if (asyncConcurrencyLimit > 0) {
+        ffprobeAsyncExecutor->setConcurrencyLimit(asyncConcurrencyLimit);
+    }
+}
+
 std::shared_ptr<ffmpegkit::Session> ffmpegkit::FFmpegKitConfig::getSession(const long sessionId) {
     std::unique_lock<std::recursive_mutex> lock(sessionMutex, std::defer_lock);
     lock.lock();
@@ -1350,7 +2588,23 @@ void ffmpegkit::FFmpegKitConfig::setLogRedirectionStrategy(const LogRedirectionS
 }
 
 int ffmpegkit::FFmpegKitConfig::messagesInTransmit(const long sessionId) {
-    return std::atomic_load(&sessionInTransitMessageCountMap[sessionId % SESSION_MAP_SIZE]);
+    SessionControl* sessionControl = sessionControlFind(sessionId);
+    if (sessionControl == nullptr) {
+        return 0;
+    }
+
+    const int count = std::atomic_load(&sessionControl->messagesInTransmit);
+
+    // THE SLOT MAY BE REUSED BY ANOTHER SESSION AFTER IT IS FOUND
+    return (std::atomic_load(&sessionControl->sessionId) == sessionId) ? count : 0;
+}
+
+bool ffmpegkit::FFmpegKitConfig::waitForMessagesInTransmit(const long sessionId, const int timeout) {
+    std::unique_lock<std::mutex> lock(messagesInTransmitMutex);
+
+    return messagesInTransmitMonitor.wait_for(lock, std::chrono::milliseconds(timeout), [sessionId]() {
+        return ffmpegkit::FFmpegKitConfig::messagesInTransmit(sessionId) == 0;
+    });
 }
 
 std::string ffmpegkit::FFmpegKitConfig::sessionStateToString(SessionState state) {
@@ -30,6 +30,7 @@
 #include "MediaInformationSession.h"
 #include "Signal.h"
 #include "StatisticsCallback.h"
+#include "StreamStatisticsCallback.h"
 #include <map>
 
 namespace ffmpegkit {
@@ -183,8 +184,14 @@ namespace ffmpegkit {
             /**
              * <p>Synchronously executes the media information session provided.
              *
+             * <p>FFprobe output is captured in memory and parsed directly, it is not forwarded to log
+             * callbacks and is not included in session logs.
+             *
+             * <p>Sessions created with default media information arguments don't run FFprobe at all,
+             * properties are extracted in-process from the opened input.
+             *
              * @param mediaInformationSession media information session which includes command options/arguments
-             * @param waitTimeout             max time to wait until media information is transmitted
+             * @param waitTimeout             deprecated and ignored, media information is no longer transmitted through logs
              */
             static void getMediaInformationExecute(const std::shared_ptr<ffmpegkit::MediaInformationSession> mediaInformationSession, const int waitTimeout);
 
@@ -192,6 +199,9 @@ namespace ffmpegkit {
              * <p>Starts an asynchronous FFmpeg execution for the given session.
              *
              * <p>Note that this method returns immediately and does not wait the execution to complete.
+             * If the concurrency limit set using setAsyncConcurrencyLimit is reached, the session is queued and stays
+             * in the created state until it can be started. Queued sessions start in the order defined by
+             * their SchedulingOptions.
              * You must use an FFmpegSessionCompleteCallback if you want to be notified about the result.
              *
              * @param ffmpegSession FFmpeg session which includes command options/arguments
@@ -202,6 +212,8 @@ namespace ffmpegkit {
              * <p>Starts an asynchronous FFprobe execution for the given session.
              *
              * <p>Note that this method returns immediately and does not wait the execution to complete.
+             * If the concurrency limit set using setAsyncFFprobeConcurrencyLimit is reached, the session is queued and stays
+             * in the created state until it can be started.
              * You must use an FFprobeSessionCompleteCallback if you want to be notified about the result.
              *
              * @param ffprobeSession FFprobe session which includes command options/arguments
@@ -212,10 +224,12 @@ namespace ffmpegkit {
              * <p>Starts an asynchronous FFprobe execution for the given media information session.
              *
              * <p>Note that this method returns immediately and does not wait the execution to complete.
+             * If the concurrency limit set using setAsyncFFprobeConcurrencyLimit is reached, the session is queued and stays
+             * in the created state until it can be started.
              * You must use an MediaInformationSessionCompleteCallback if you want to be notified about the result.
              *
              * @param mediaInformationSession media information session which includes command options/arguments
-             * @param waitTimeout             max time to wait until media information is transmitted
+             * @param waitTimeout             deprecated and ignored, media information is no longer transmitted through logs
              */
             static void asyncGetMediaInformationExecute(const std::shared_ptr<ffmpegkit::MediaInformationSession> mediaInformationSession, int waitTimeout);
 
@@ -233,6 +247,15 @@ namespace ffmpegkit {
              */
             static void enableStatisticsCallback(const ffmpegkit::StatisticsCallback statisticsCallback);
 
+            /**
+             * <p>Sets a global stream statistics callback to receive the statistics of the input and
+             * output streams of FFmpeg sessions. Stream statistics are delivered with every statistics
+             * update while they are enabled using enableStreamStatistics.
+             *
+             * @param streamStatisticsCallback stream statistics callback or nullptr to disable a previously defined stream statistics callback
+             */
+            static void enableStreamStatisticsCallback(const ffmpegkit::StreamStatisticsCallback streamStatisticsCallback);
+
             /**
              * <p>Sets a global FFmpegSessionCompleteCallback to receive execution results for FFmpeg sessions.
              *
@@ -308,10 +331,122 @@ namespace ffmpegkit {
             /**
              * Sets the session history size.
              *
-             * @param sessionHistorySize session history size, should be smaller than 1000
+             * @param sessionHistorySize session history size
              */
             static void setSessionHistorySize(const int sessionHistorySize);
 
+            /**
+             * <p>Sets the default log retention limits of new sessions. When a session exceeds a limit
+             * its oldest log entries are removed. Zero means no limit, which is the default.
+             *
+             * <p>Limits of an existing session can be changed using Session::setLogRetention.
+             *
+             * @param lineLimit maximum number of log entries kept by a session
+             * @param byteLimit maximum total size of log messages kept by a session in bytes
+             */
+            static void setLogRetention(const int lineLimit, const long byteLimit);
+
+            /**
+             * Returns the default maximum number of log entries kept by a session.
+             *
+             * @return line limit, zero if there is no limit
+             */
+            static int getLogRetentionLineLimit();
+
+            /**
+             * Returns the default maximum total size of log messages kept by a session.
+             *
+             * @return byte limit, zero if there is no limit
+             */
+            static long getLogRetentionByteLimit();
+
+            /**
+             * <p>Sets the maximum number of statistics entries kept by new FFmpeg sessions. When the
+             * limit is exceeded the oldest entries are removed. Zero means no limit. Defaults to 1000.
+             *
+             * <p>The limit of an existing session can be changed using FFmpegSession::setStatisticsRetention.
+             *
+             * @param entryLimit maximum number of statistics entries kept by a session
+             */
+            static void setStatisticsRetention(const int entryLimit);
+
+            /**
+             * Returns the default maximum number of statistics entries kept by an FFmpeg session.
+             *
+             * @return entry limit, zero if there is no limit
+             */
+            static int getStatisticsRetention();
+
+            /**
+             * <p>Sets how many statistics updates per second are delivered for a session at most.
+             * Updates that arrive faster are coalesced, only the latest values are delivered. The last
+             * update of a session is always delivered. Zero means no limit, which is the default.
+             *
+             * <p>Updates that are not consumed yet are coalesced even without a limit, so a slow
+             * statistics callback never makes statistics pile up.
+             *
+             * <p>The rate applies to sessions started after this method is called.
+             *
+             * @param maxRate maximum number of statistics updates delivered per second for a session
+             */
+            static void setStatisticsMaxRate(const int maxRate);
+
+            /**
+             * Returns the maximum number of statistics updates delivered per second for a session.
+             *
+             * @return maximum rate, zero if there is no limit
+             */
+            static int getStatisticsMaxRate();
+
+            /**
+             * <p>Enables collecting per stream packet and frame counters, queue depths and the wall
+             * and CPU time spent in decoding, filtering, encoding and muxing. Stream statistics are
+             * attached to Statistics entries and passed to the stream statistics callback.
+             *
+             * <p>Stage times are only measured while stream statistics are enabled. Disabled by
+             * default.
+             */
+            static void enableStreamStatistics();
+
+            /**
+             * <p>Disables collecting stream statistics.
+             */
+            static void disableStreamStatistics();
+
+            /**
+             * Returns the maximum number of asynchronous FFmpeg sessions that are executed in parallel.
+             *
+             * @return FFmpeg async concurrency limit, defaults to the number of available processors
+             */
+            static int getAsyncConcurrencyLimit();
+
+            /**
+             * <p>Sets the maximum number of asynchronous FFmpeg sessions that are executed in parallel.
+             * Sessions submitted after the limit is reached are queued in submission order.
+             *
+             * <p>Lowering the limit does not stop sessions that are already running.
+             *
+             * @param asyncConcurrencyLimit new limit, must be greater than zero
+             */
+            static void setAsyncConcurrencyLimit(const int asyncConcurrencyLimit);
+
+            /**
+             * Returns the maximum number of asynchronous FFprobe and media information sessions that are
+             * executed in parallel.
+             *
+             * @return FFprobe async concurrency limit, defaults to the number of available processors
+             */
+            static int getAsyncFFprobeConcurrencyLimit();
+
+            /**
+             * Sets the maximum number of asynchronous FFprobe and media information sessions that are
+             * executed in parallel. FFprobe sessions are queued separately from FFmpeg sessions, so
+             * probes are not delayed by long running transcodes.
+             *
+             * @param asyncConcurrencyLimit new limit, must be greater than zero
+             */
+            static void setAsyncFFprobeConcurrencyLimit(const int asyncConcurrencyLimit);
+
             /**
              * Returns the session specified with <code>sessionId</code> from the session history.
              *
@@ -399,6 +534,16 @@ namespace ffmpegkit {
              */
             static int messagesInTransmit(const long sessionId);
 
+            /**
+             * <p>Waits until all async messages of this session are transmitted to the callbacks or
+             * the given timeout expires. Returns as soon as the last message is transmitted.
+             *
+             * @param sessionId id of the session
+             * @param timeout   wait timeout in milliseconds
+             * @return true if all messages are transmitted, false if the timeout expired
+             */
+            static bool waitForMessagesInTransmit(const long sessionId, const int timeout);
+
             /**
              * Converts session state to string.
              *
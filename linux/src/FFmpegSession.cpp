@@ -21,41 +21,54 @@
 #include "FFmpegKitConfig.h"
 #include "LogCallback.h"
 #include "StatisticsCallback.h"
+#include <algorithm>
 
 extern void addSessionToSessionHistory(const std::shared_ptr<ffmpegkit::Session> session);
 
 std::shared_ptr<ffmpegkit::FFmpegSession> ffmpegkit::FFmpegSession::create(const std::list<std::string>& arguments) {
-    std::shared_ptr<ffmpegkit::FFmpegSession> session = std::static_pointer_cast<ffmpegkit::FFmpegSession>(std::make_shared<ffmpegkit::FFmpegSession::PublicFFmpegSession>(arguments, nullptr, nullptr, nullptr, ffmpegkit::FFmpegKitConfig::getLogRedirectionStrategy()));
+    std::shared_ptr<ffmpegkit::FFmpegSession> session = std::static_pointer_cast<ffmpegkit::FFmpegSession>(std::make_shared<ffmpegkit::FFmpegSession::PublicFFmpegSession>(arguments, nullptr, nullptr, nullptr, ffmpegkit::FFmpegKitConfig::getLogRedirectionStrategy(), ffmpegkit::SchedulingOptions()));
     addSessionToSessionHistory(session);
     return session;
 }
 
 std::shared_ptr<ffmpegkit::FFmpegSession> ffmpegkit::FFmpegSession::create(const std::list<std::string>& arguments, FFmpegSessionCompleteCallback completeCallback) {
-    std::shared_ptr<ffmpegkit::FFmpegSession> session = std::static_pointer_cast<ffmpegkit::FFmpegSession>(std::make_shared<ffmpegkit::FFmpegSession::PublicFFmpegSession>(arguments, completeCallback, nullptr, nullptr, ffmpegkit::FFmpegKitConfig::getLogRedirectionStrategy()));
+    std::shared_ptr<ffmpegkit::FFmpegSession> session = std::static_pointer_cast<ffmpegkit::FFmpegSession>(std::make_shared<ffmpegkit::FFmpegSession::PublicFFmpegSession>(arguments, completeCallback, nullptr, nullptr, ffmpegkit::FFmpegKitConfig::getLogRedirectionStrategy(), ffmpegkit::SchedulingOptions()));
     addSessionToSessionHistory(session);
     return session;
 }
 
 std::shared_ptr<ffmpegkit::FFmpegSession> ffmpegkit::FFmpegSession::create(const std::list<std::string>& arguments, FFmpegSessionCompleteCallback completeCallback, ffmpegkit::LogCallback logCallback, ffmpegkit::StatisticsCallback statisticsCallback) {
-    std::shared_ptr<ffmpegkit::FFmpegSession> session = std::static_pointer_cast<ffmpegkit::FFmpegSession>(std::make_shared<ffmpegkit::FFmpegSession::PublicFFmpegSession>(arguments, completeCallback, logCallback, statisticsCallback, ffmpegkit::FFmpegKitConfig::getLogRedirectionStrategy()));
+    std::shared_ptr<ffmpegkit::FFmpegSession> session = std::static_pointer_cast<ffmpegkit::FFmpegSession>(std::make_shared<ffmpegkit::FFmpegSession::PublicFFmpegSession>(arguments, completeCallback, logCallback, statisticsCallback, ffmpegkit::FFmpegKitConfig::getLogRedirectionStrategy(), ffmpegkit::SchedulingOptions()));
     addSessionToSessionHistory(session);
     return session;
 }
 
 std::shared_ptr<ffmpegkit::FFmpegSession> ffmpegkit::FFmpegSession::create(const std::list<std::string>& arguments, FFmpegSessionCompleteCallback completeCallback, ffmpegkit::LogCallback logCallback, ffmpegkit::StatisticsCallback statisticsCallback, LogRedirectionStrategy logRedirectionStrategy) {
-    std::shared_ptr<ffmpegkit::FFmpegSession> session = std::static_pointer_cast<ffmpegkit::FFmpegSession>(std::make_shared<ffmpegkit::FFmpegSession::PublicFFmpegSession>(arguments, completeCallback, logCallback, statisticsCallback, logRedirectionStrategy));
+    std::shared_ptr<ffmpegkit::FFmpegSession> session = std::static_pointer_cast<ffmpegkit::FFmpegSession>(std::make_shared<ffmpegkit::FFmpegSession::PublicFFmpegSession>(arguments, completeCallback, logCallback, statisticsCallback, logRedirectionStrategy, ffmpegkit::SchedulingOptions()));
+    addSessionToSessionHistory(session);
+    return session;
+}
+
+std::shared_ptr<ffmpegkit::FFmpegSession> ffmpegkit::FFmpegSession::create(const std::list<std::string>& arguments, FFmpegSessionCompleteCallback completeCallback, const ffmpegkit::SchedulingOptions& schedulingOptions) {
+    std::shared_ptr<ffmpegkit::FFmpegSession> session = std::static_pointer_cast<ffmpegkit::FFmpegSession>(std::make_shared<ffmpegkit::FFmpegSession::PublicFFmpegSession>(arguments, completeCallback, nullptr, nullptr, ffmpegkit::FFmpegKitConfig::getLogRedirectionStrategy(), schedulingOptions));
+    addSessionToSessionHistory(session);
+    return session;
+}
+
+std::shared_ptr<ffmpegkit::FFmpegSession> ffmpegkit::FFmpegSession::create(const std::list<std::string>& arguments, FFmpegSessionCompleteCallback completeCallback, ffmpegkit::LogCallback logCallback, ffmpegkit::StatisticsCallback statisticsCallback, LogRedirectionStrategy logRedirectionStrategy, const ffmpegkit::SchedulingOptions& schedulingOptions) {
+    std::shared_ptr<ffmpegkit::FFmpegSession> session = std::static_pointer_cast<ffmpegkit::FFmpegSession>(std::make_shared<ffmpegkit::FFmpegSession::PublicFFmpegSession>(arguments, completeCallback, logCallback, statisticsCallback, logRedirectionStrategy, schedulingOptions));
     addSessionToSessionHistory(session);
     return session;
 }
 
 struct ffmpegkit::FFmpegSession::PublicFFmpegSession : public ffmpegkit::FFmpegSession {
-    PublicFFmpegSession(const std::list<std::string>& arguments, FFmpegSessionCompleteCallback completeCallback, ffmpegkit::LogCallback logCallback, ffmpegkit::StatisticsCallback statisticsCallback, LogRedirectionStrategy logRedirectionStrategy) :
-      FFmpegSession(arguments, completeCallback, logCallback, statisticsCallback, logRedirectionStrategy) {
+    PublicFFmpegSession(const std::list<std::string>& arguments, FFmpegSessionCompleteCallback completeCallback, ffmpegkit::LogCallback logCallback, ffmpegkit::StatisticsCallback statisticsCallback, LogRedirectionStrategy logRedirectionStrategy, const ffmpegkit::SchedulingOptions& schedulingOptions) :
+      FFmpegSession(arguments, completeCallback, logCallback, statisticsCallback, logRedirectionStrategy, schedulingOptions) {
     }
 };
 
-ffmpegkit::FFmpegSession::FFmpegSession(const std::list<std::string>& arguments, FFmpegSessionCompleteCallback completeCallback, ffmpegkit::LogCallback logCallback, ffmpegkit::StatisticsCallback statisticsCallback, LogRedirectionStrategy logRedirectionStrategy) :
-    ffmpegkit::AbstractSession(arguments, logCallback, logRedirectionStrategy), _completeCallback{completeCallback}, _statisticsCallback{statisticsCallback}, _statistics{std::make_shared<std::list<std::shared_ptr<ffmpegkit::Statistics>>>()} {
+ffmpegkit::FFmpegSession::FFmpegSession(const std::list<std::string>& arguments, FFmpegSessionCompleteCallback completeCallback, ffmpegkit::LogCallback logCallback, ffmpegkit::StatisticsCallback statisticsCallback, LogRedirectionStrategy logRedirectionStrategy, const ffmpegkit::SchedulingOptions& schedulingOptions) :
+    ffmpegkit::AbstractSession(arguments, logCallback, logRedirectionStrategy, schedulingOptions), _completeCallback{completeCallback}, _statisticsCallback{statisticsCallback}, _statisticsLimit{ffmpegkit::FFmpegKitConfig::getStatisticsRetention()} {
 }
 
 ffmpegkit::StatisticsCallback ffmpegkit::FFmpegSession::getStatisticsCallback() {
@@ -81,19 +94,47 @@ std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::Statistics>>> ffmpegkit::FF
 }
 
 std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::Statistics>>> ffmpegkit::FFmpegSession::getStatistics() {
-    return _statistics;
+    std::unique_lock<std::mutex> lock(_statisticsMutex, std::defer_lock);
+    lock.lock();
+
+    return std::make_shared<std::list<std::shared_ptr<ffmpegkit::Statistics>>>(_statistics.cbegin(), _statistics.cend());
 }
 
 std::shared_ptr<ffmpegkit::Statistics> ffmpegkit::FFmpegSession::getLastReceivedStatistics() {
-    if (_statistics->size() > 0) {
-        return _statistics->back();
-    } else {
-        return nullptr;
-    }
+    return std::atomic_load(&_lastStatistics);
+}
+
+void ffmpegkit::FFmpegSession::setStatisticsRetention(const int entryLimit) {
+    std::unique_lock<std::mutex> lock(_statisticsMutex, std::defer_lock);
+    lock.lock();
+
+    _statisticsLimit = std::max(entryLimit, 0);
+    trimStatistics();
+}
+
+void ffmpegkit::FFmpegSession::setTraceFile(const std::string& path) {
+    _traceFile = path;
+}
+
+std::string ffmpegkit::FFmpegSession::getTraceFile() {
+    return _traceFile;
 }
 
 void ffmpegkit::FFmpegSession::addStatistics(const std::shared_ptr<ffmpegkit::Statistics> statistics) {
-    _statistics->push_back(statistics);
+    std::unique_lock<std::mutex> lock(_statisticsMutex, std::defer_lock);
+    lock.lock();
+
+    _statistics.push_back(statistics);
+    trimStatistics();
+    lock.unlock();
+
+    std::atomic_store(&_lastStatistics, statistics);
+}
+
+void ffmpegkit::FFmpegSession::trimStatistics() {
+    while (_statisticsLimit > 0 && _statistics.size() > (size_t)_statisticsLimit) {
+        _statistics.pop_front();
+    }
 }
 
 bool ffmpegkit::FFmpegSession::isFFmpeg() const {
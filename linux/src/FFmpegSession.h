@@ -72,6 +72,29 @@ namespace ffmpegkit {
              */
             static std::shared_ptr<ffmpegkit::FFmpegSession> create(const std::list<std::string>& arguments, ffmpegkit::FFmpegSessionCompleteCallback completeCallback, ffmpegkit::LogCallback logCallback, ffmpegkit::StatisticsCallback statisticsCallback, ffmpegkit::LogRedirectionStrategy logRedirectionStrategy);
 
+            /**
+             * Builds a new FFmpeg session.
+             *
+             * @param arguments          command arguments
+             * @param completeCallback   session specific complete callback
+             * @param schedulingOptions  options used when the session is executed asynchronously
+             * @return created session
+             */
+            static std::shared_ptr<ffmpegkit::FFmpegSession> create(const std::list<std::string>& arguments, ffmpegkit::FFmpegSessionCompleteCallback completeCallback, const ffmpegkit::SchedulingOptions& schedulingOptions);
+
+            /**
+             * Builds a new FFmpeg session.
+             *
+             * @param arguments               command arguments
+             * @param completeCallback        session specific complete callback
+             * @param logCallback             session specific log callback
+             * @param statisticsCallback      session specific statistics callback
+             * @param logRedirectionStrategy  session specific log redirection strategy
+             * @param schedulingOptions       options used when the session is executed asynchronously
+             * @return created session
+             */
+            static std::shared_ptr<ffmpegkit::FFmpegSession> create(const std::list<std::string>& arguments, ffmpegkit::FFmpegSessionCompleteCallback completeCallback, ffmpegkit::LogCallback logCallback, ffmpegkit::StatisticsCallback statisticsCallback, ffmpegkit::LogRedirectionStrategy logRedirectionStrategy, const ffmpegkit::SchedulingOptions& schedulingOptions);
+
             /**
              * Returns the session specific statistics callback.
              *
@@ -87,40 +110,76 @@ namespace ffmpegkit {
             ffmpegkit::FFmpegSessionCompleteCallback getCompleteCallback();
 
             /**
-             * Returns all statistics entries generated for this session. If there are asynchronous
+             * Returns the statistics entries kept for this session. If there are asynchronous
              * messages that are not delivered yet, this method waits for them until the given timeout.
              *
+             * <p>Sessions keep only the last 1000 entries by default, see setStatisticsRetention.
+             * The list returned is a copy, entries delivered later are not added to it.
+             *
              * @param waitTimeout wait timeout for asynchronous messages in milliseconds
-             * @return list of statistics entries generated for this session
+             * @return copy of the statistics entries kept for this session
              */
             std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::Statistics>>> getAllStatisticsWithTimeout(const int waitTimeout);
 
             /**
-             * Returns all statistics entries generated for this session. If there are asynchronous
+             * Returns the statistics entries kept for this session. If there are asynchronous
              * messages that are not delivered yet, this method waits for them until
              * AbstractSessionDefaultTimeoutForAsynchronousMessagesInTransmit expires.
              *
-             * @return list of statistics entries generated for this session
+             * <p>Sessions keep only the last 1000 entries by default, see setStatisticsRetention.
+             * The list returned is a copy, entries delivered later are not added to it.
+             *
+             * @return copy of the statistics entries kept for this session
              */
             std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::Statistics>>> getAllStatistics();
 
             /**
-             * Returns all statistics entries delivered for this session. Note that if there are
-             * asynchronous messages that are not delivered yet, this method will not wait for
+             * Returns the statistics entries delivered and kept for this session. Note that if there
+             * are asynchronous messages that are not delivered yet, this method will not wait for
              * them and will return immediately.
              *
-             * @return list of statistics entries received for this session
+             * <p>Sessions keep only the last 1000 entries by default, see setStatisticsRetention.
+             * The list returned is a copy, entries delivered later are not added to it.
+             *
+             * @return copy of the statistics entries received and kept for this session
              */
             std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::Statistics>>> getStatistics();
 
             /**
-             * Returns the last received statistics entry.
+             * Returns the last received statistics entry. Does not wait for the statistics lock, so it
+             * can be polled while statistics are being delivered.
              *
              * @return the last received statistics entry or nullptr if there are not any statistics entries
              * received
              */
             std::shared_ptr<ffmpegkit::Statistics> getLastReceivedStatistics();
 
+            /**
+             * Sets how many statistics entries this session keeps. When the limit is exceeded the oldest
+             * entries are removed. Zero means no limit. Sessions are created with the limit set using
+             * FFmpegKitConfig::setStatisticsRetention.
+             *
+             * @param entryLimit maximum number of statistics entries
+             */
+            void setStatisticsRetention(const int entryLimit);
+
+            /**
+             * Enables tracing for this session. When the session completes, a Chrome trace JSON file
+             * is written to the given path. It holds the demux reads, decode, filter, encode and mux
+             * spans of every ffmpeg thread. It can be opened in chrome://tracing or Perfetto. Must be
+             * called before the session is executed.
+             *
+             * @param path trace file path or an empty string to disable tracing, which is the default
+             */
+            void setTraceFile(const std::string& path);
+
+            /**
+             * Returns the trace file path of this session.
+             *
+             * @return trace file path or an empty string if tracing is disabled
+             */
+            std::string getTraceFile();
+
             /**
              * Adds a new statistics entry for this session. It is invoked internally by <code>FFmpegKit</code> library methods.
              * Must not be used by user applications.
@@ -162,12 +221,23 @@ namespace ffmpegkit {
              * @param logCallback             session specific log callback
              * @param statisticsCallback      session specific statistics callback
              * @param logRedirectionStrategy  session specific log redirection strategy
+             * @param schedulingOptions       options used when the session is executed asynchronously
              */
-            FFmpegSession(const std::list<std::string>& arguments, ffmpegkit::FFmpegSessionCompleteCallback completeCallback, ffmpegkit::LogCallback logCallback, ffmpegkit::StatisticsCallback statisticsCallback, ffmpegkit::LogRedirectionStrategy logRedirectionStrategy);
+            FFmpegSession(const std::list<std::string>& arguments, ffmpegkit::FFmpegSessionCompleteCallback completeCallback, ffmpegkit::LogCallback logCallback, ffmpegkit::StatisticsCallback statisticsCallback, ffmpegkit::LogRedirectionStrategy logRedirectionStrategy, const ffmpegkit::SchedulingOptions& schedulingOptions);
 
             ffmpegkit::StatisticsCallback _statisticsCallback;
             FFmpegSessionCompleteCallback _completeCallback;
-            std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::Statistics>>> _statistics;
+            /**
+             * Removes the oldest statistics entries until the retention limit is met. Must be called
+             * while holding the statistics mutex.
+             */
+            void trimStatistics();
+
+            std::deque<std::shared_ptr<ffmpegkit::Statistics>> _statistics;
+            std::shared_ptr<ffmpegkit::Statistics> _lastStatistics;
+            int _statisticsLimit;
+            std::mutex _statisticsMutex;
+            std::string _traceFile;
     };
 
 }
@@ -130,7 +130,7 @@ namespace ffmpegkit {
              * <p>Extracts media information for the file specified with path.
              *
              * @param path        path or uri of a media file
-             * @param waitTimeout max time to wait until media information is transmitted
+             * @param waitTimeout deprecated and ignored, media information is no longer transmitted through logs
              * @return media information session created for this execution
              */
             static std::shared_ptr<ffmpegkit::MediaInformationSession> getMediaInformation(const std::string path, const int waitTimeout);
@@ -156,7 +156,7 @@ namespace ffmpegkit {
              * @param path             path or uri of a media file
              * @param completeCallback callback that will be notified when execution has completed
              * @param logCallback      callback that will receive logs
-             * @param waitTimeout      max time to wait until media information is transmitted
+             * @param waitTimeout      deprecated and ignored, media information is no longer transmitted through logs
              * @return media information session created for this execution
              */
             static std::shared_ptr<ffmpegkit::MediaInformationSession> getMediaInformationAsync(const std::string path, MediaInformationSessionCompleteCallback completeCallback, ffmpegkit::LogCallback logCallback, const int waitTimeout);
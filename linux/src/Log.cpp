@@ -33,3 +33,7 @@ ffmpegkit::Level ffmpegkit::Log::getLevel() const {
 std::string ffmpegkit::Log::getMessage() const {
     return _message;
 }
+
+size_t ffmpegkit::Log::getMessageLength() const {
+    return _message.size();
+}
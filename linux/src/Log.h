@@ -34,6 +34,7 @@ namespace ffmpegkit {
             long getSessionId() const;
             ffmpegkit::Level getLevel() const;
             std::string getMessage() const;
+            size_t getMessageLength() const;
 
         private:
             long _sessionId;
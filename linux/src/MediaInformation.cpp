@@ -18,6 +18,7 @@
  */
 
 #include "MediaInformation.h"
+#include "MediaInformationJsonParser.h"
 
 ffmpegkit::MediaInformation::MediaInformation(std::shared_ptr<rapidjson::Value> mediaInformationValue, std::shared_ptr<std::vector<std::shared_ptr<ffmpegkit::StreamInformation>>> streams, std::shared_ptr<std::vector<std::shared_ptr<ffmpegkit::Chapter>>> chapters) :
     _mediaInformationValue{mediaInformationValue}, _streams{streams}, _chapters{chapters} {
@@ -52,14 +53,7 @@ std::shared_ptr<std::string> ffmpegkit::MediaInformation::getBitrate() {
 }
 
 std::shared_ptr<rapidjson::Value> ffmpegkit::MediaInformation::getTags() {
-    auto formatProperties = getFormatProperties();
-    if (formatProperties->HasMember(KeyTags)) {
-        auto tags = std::make_shared<rapidjson::Value>();
-        *tags = (*formatProperties)[KeyTags];
-        return tags;
-    } else {
-        return nullptr;
-    }
+    return getFormatProperty(KeyTags);
 }
 
 std::shared_ptr<std::vector<std::shared_ptr<ffmpegkit::StreamInformation>>> ffmpegkit::MediaInformation::getStreams() {
@@ -71,79 +65,63 @@ std::shared_ptr<std::vector<std::shared_ptr<ffmpegkit::Chapter>>> ffmpegkit::Med
 }
 
 std::shared_ptr<std::string> ffmpegkit::MediaInformation::getStringProperty(const char* key) {
-    auto allProperties = getAllProperties();
-    if (allProperties->HasMember(key)) {
-        return std::make_shared<std::string>((*allProperties)[key].GetString());
+    const rapidjson::Value* value = ffmpegkit::MediaInformationJsonParser::findMember(_mediaInformationValue.get(), key);
+    if (value != nullptr) {
+        return std::make_shared<std::string>(value->GetString(), value->GetStringLength());
     } else {
         return nullptr;
     }
 }
 
 std::shared_ptr<int64_t> ffmpegkit::MediaInformation::getNumberProperty(const char* key) {
-    auto allProperties = getAllProperties();
-    if (allProperties->HasMember(key)) {
-        return std::make_shared<int64_t>((*allProperties)[key].GetInt64());
+    const rapidjson::Value* value = ffmpegkit::MediaInformationJsonParser::findMember(_mediaInformationValue.get(), key);
+    if (value != nullptr) {
+        return std::make_shared<int64_t>(value->GetInt64());
     } else {
         return nullptr;
     }
 }
 
 std::shared_ptr<rapidjson::Value> ffmpegkit::MediaInformation::getProperty(const char* key) {
-    auto allProperties = getAllProperties();
-    if (allProperties->HasMember(key)) {
-        auto value = std::make_shared<rapidjson::Value>();
-        *value = (*allProperties)[key];
-        return value;
+    rapidjson::Value* value = ffmpegkit::MediaInformationJsonParser::findMember(_mediaInformationValue.get(), key);
+    if (value != nullptr) {
+        return std::shared_ptr<rapidjson::Value>(_mediaInformationValue, value);
     } else {
         return nullptr;
     }
 }
 
 std::shared_ptr<std::string> ffmpegkit::MediaInformation::getStringFormatProperty(const char* key) {
-    auto formatProperties = getFormatProperties();
-    if (formatProperties->HasMember(key)) {
-        return std::make_shared<std::string>((*formatProperties)[key].GetString());
+    const rapidjson::Value* value = ffmpegkit::MediaInformationJsonParser::findMember(ffmpegkit::MediaInformationJsonParser::findMember(_mediaInformationValue.get(), KeyFormatProperties), key);
+    if (value != nullptr) {
+        return std::make_shared<std::string>(value->GetString(), value->GetStringLength());
     } else {
         return nullptr;
     }
 }
 
 std::shared_ptr<int64_t> ffmpegkit::MediaInformation::getNumberFormatProperty(const char* key) {
-    auto formatProperties = getFormatProperties();
-    if (formatProperties->HasMember(key)) {
-        return std::make_shared<int64_t>((*formatProperties)[key].GetInt64());
+    const rapidjson::Value* value = ffmpegkit::MediaInformationJsonParser::findMember(ffmpegkit::MediaInformationJsonParser::findMember(_mediaInformationValue.get(), KeyFormatProperties), key);
+    if (value != nullptr) {
+        return std::make_shared<int64_t>(value->GetInt64());
     } else {
         return nullptr;
     }
 }
 
 std::shared_ptr<rapidjson::Value> ffmpegkit::MediaInformation::getFormatProperty(const char* key) {
-    auto formatProperties = getFormatProperties();
-    if (formatProperties->HasMember(key)) {
-        auto value = std::make_shared<rapidjson::Value>();
-        *value = (*formatProperties)[key];
-        return value;
+    rapidjson::Value* value = ffmpegkit::MediaInformationJsonParser::findMember(ffmpegkit::MediaInformationJsonParser::findMember(_mediaInformationValue.get(), KeyFormatProperties), key);
+    if (value != nullptr) {
+        return std::shared_ptr<rapidjson::Value>(_mediaInformationValue, value);
     } else {
         return nullptr;
     }
 }
 
 std::shared_ptr<rapidjson::Value> ffmpegkit::MediaInformation::getFormatProperties() {
-    if (_mediaInformationValue->HasMember(KeyFormatProperties)) {
-        auto mediaProperties = std::make_shared<rapidjson::Value>();
-        *mediaProperties = (*_mediaInformationValue)[KeyFormatProperties];
-        return mediaProperties;
-    } else {
-        return nullptr;
-    }
+    return getProperty(KeyFormatProperties);
 }
 
 std::shared_ptr<rapidjson::Value> ffmpegkit::MediaInformation::getAllProperties() {
-    if (_mediaInformationValue != nullptr) {
-        auto all = std::make_shared<rapidjson::Value>();
-        *all = (*_mediaInformationValue);
-        return all;
-    } else {
-        return nullptr;
-    }
+    return _mediaInformationValue;
 }
@@ -29,6 +29,9 @@ namespace ffmpegkit {
 
     /**
      * Media information class.
+     *
+     * <p>Values returned by property getters point into the parsed document. They are not copies,
+     * streams and chapters keep the same document alive.
      */
     class MediaInformation {
         public:
@@ -0,0 +1,444 @@
+/*
+ * Copyright (c) 2022 Taner Sener
+ *
+ * This file is part of FFmpegKit.
+ *
+ * FFmpegKit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpegKit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpegKit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MediaInformationCache.h"
+#include "MediaInformationJsonParser.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include <sys/stat.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+static const char* MediaInformationCacheIndexHeader = "ffmpeg-kit-media-information-index 1";
+
+/**
+ * Minimum time between two index writes triggered by cache changes.
+ */
+static const std::chrono::milliseconds MediaInformationCacheIndexSaveInterval(5000);
+
+/**
+ * Identifies a version of a file on disk.
+ */
+struct MediaInformationCacheKey {
+    int64_t device;
+    int64_t inode;
+    int64_t size;
+    int64_t modificationSeconds;
+    int64_t modificationNanoseconds;
+
+    bool operator==(const MediaInformationCacheKey& other) const {
+        return device == other.device && inode == other.inode && size == other.size &&
+            modificationSeconds == other.modificationSeconds && modificationNanoseconds == other.modificationNanoseconds;
+    }
+};
+
+/**
+ * A cache entry. Entries loaded from the index file keep their json text and are parsed on first use.
+ * The media information of an entry is never handed out, callers receive copies of it.
+ */
+struct MediaInformationCacheEntry {
+    std::string path;
+    MediaInformationCacheKey key;
+    std::shared_ptr<ffmpegkit::MediaInformation> mediaInformation;
+    std::string json;
+};
+
+typedef std::list<MediaInformationCacheEntry> MediaInformationCacheList;
+
+static std::mutex cacheMutex;
+static MediaInformationCacheList cacheList;
+static std::unordered_map<std::string, MediaInformationCacheList::iterator> cacheMap;
+static int cacheSize = 0;
+static std::string cacheIndexPath;
+static std::atomic<long> cacheHitCount(0);
+static std::atomic<long> cacheMissCount(0);
+
+/* index writes, the index is written from a snapshot outside the cache mutex */
+static bool cacheIndexDirty = false;
+static std::chrono::steady_clock::time_point cacheIndexSaveTime;
+static long cacheIndexGeneration = 0;
+static std::mutex cacheIndexWriteMutex;
+static long cacheIndexWrittenGeneration = 0;
+
+/**
+ * Entries of the index at one point in time.
+ */
+struct MediaInformationCacheIndexSnapshot {
+    std::string indexPath;
+    long generation;
+    std::vector<MediaInformationCacheEntry> entries;
+};
+
+static bool statKey(const std::string& path, MediaInformationCacheKey& key) {
+    struct stat fileStat;
+
+    if (stat(path.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) {
+        return false;
+    }
+
+    key.device = fileStat.st_dev;
+    key.inode = fileStat.st_ino;
+    key.size = fileStat.st_size;
+    key.modificationSeconds = fileStat.st_mtim.tv_sec;
+    key.modificationNanoseconds = fileStat.st_mtim.tv_nsec;
+
+    return true;
+}
+
+static std::string toJson(const std::shared_ptr<ffmpegkit::MediaInformation> mediaInformation) {
+    auto allProperties = mediaInformation->getAllProperties();
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+
+    if (allProperties == nullptr || !allProperties->Accept(writer)) {
+        return std::string();
+    }
+
+    return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+/**
+ * Copies media information into a new document, so the copy can be modified without changing the
+ * original.
+ *
+ * @param mediaInformation media information to copy
+ * @return copy or nullptr if the media information has no properties
+ */
+static std::shared_ptr<ffmpegkit::MediaInformation> copyMediaInformation(const std::shared_ptr<ffmpegkit::MediaInformation> mediaInformation) {
+    auto allProperties = mediaInformation->getAllProperties();
+
+    if (allProperties == nullptr) {
+        return nullptr;
+    }
+
+    auto document = std::make_shared<rapidjson::Document>();
+    document->CopyFrom(*allProperties, document->GetAllocator());
+
+    return ffmpegkit::MediaInformationJsonParser::fromDocument(document);
+}
+
+static void removeEntry(MediaInformationCacheList::iterator entry) {
+    cacheMap.erase(entry->path);
+    cacheList.erase(entry);
+}
+
+static void trimEntries() {
+    while (cacheList.size() > (size_t)cacheSize) {
+        removeEntry(std::prev(cacheList.end()));
+    }
+}
+
+static void insertEntry(MediaInformationCacheEntry&& newEntry) {
+    auto existing = cacheMap.find(newEntry.path);
+    if (existing != cacheMap.end()) {
+        removeEntry(existing->second);
+    }
+
+    cacheList.push_front(std::move(newEntry));
+    cacheMap[cacheList.front().path] = cacheList.begin();
+
+    trimEntries();
+}
+
+/**
+ * Takes a snapshot of the entries if the index has unsaved changes. Unless forced, a snapshot is only
+ * taken once the save interval has passed since the last one. Must be called while holding the cache
+ * mutex.
+ *
+ * @param snapshot snapshot to fill
+ * @param force take the snapshot even if the save interval has not passed
+ * @return true if the snapshot must be written
+ */
+static bool snapshotIndex(MediaInformationCacheIndexSnapshot& snapshot, const bool force) {
+    const auto now = std::chrono::steady_clock::now();
+
+    if (cacheIndexPath.empty() || !cacheIndexDirty) {
+        return false;
+    }
+    if (!force && cacheIndexGeneration > 0 && now - cacheIndexSaveTime < MediaInformationCacheIndexSaveInterval) {
+        return false;
+    }
+
+    snapshot.indexPath = cacheIndexPath;
+    snapshot.generation = ++cacheIndexGeneration;
+
+    // LEAST RECENTLY USED ENTRIES FIRST, SO LOADING THE INDEX RESTORES THE SAME ORDER
+    snapshot.entries.assign(cacheList.rbegin(), cacheList.rend());
+
+    cacheIndexDirty = false;
+    cacheIndexSaveTime = now;
+
+    return true;
+}
+
+/**
+ * Rewrites the index file from a snapshot. Must be called without holding the cache mutex. A snapshot
+ * older than the last one written is dropped.
+ *
+ * <p>Each entry is written on a single line as "device inode size mtime_sec mtime_nsec path_length
+ * path json". Json written by rapidjson does not include new lines.
+ */
+static void writeIndex(const MediaInformationCacheIndexSnapshot& snapshot) {
+    std::unique_lock<std::mutex> lock(cacheIndexWriteMutex, std::defer_lock);
+    lock.lock();
+
+    if (snapshot.generation < cacheIndexWrittenGeneration) {
+        return;
+    }
+    cacheIndexWrittenGeneration = snapshot.generation;
+
+    const std::string temporaryPath = snapshot.indexPath + ".tmp";
+    std::ofstream index(temporaryPath, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!index.is_open()) {
+        std::cout << "Failed to write media information cache index: " << temporaryPath << std::endl;
+        return;
+    }
+
+    index << MediaInformationCacheIndexHeader << '\n';
+
+    for (const auto& entry : snapshot.entries) {
+        const std::string json = (entry.json.empty() && entry.mediaInformation != nullptr) ? toJson(entry.mediaInformation) : entry.json;
+        if (!json.empty()) {
+            index << entry.key.device << ' ' << entry.key.inode << ' ' << entry.key.size << ' '
+                << entry.key.modificationSeconds << ' ' << entry.key.modificationNanoseconds << ' '
+                << entry.path.size() << ' ' << entry.path << ' ' << json << '\n';
+        }
+    }
+
+    index.close();
+    if (index.fail() || rename(temporaryPath.c_str(), snapshot.indexPath.c_str()) != 0) {
+        std::cout << "Failed to write media information cache index: " << snapshot.indexPath << std::endl;
+        remove(temporaryPath.c_str());
+    }
+}
+
+/**
+ * Records a cache change and writes the index if the save interval has passed. Must be called while
+ * holding the cache mutex, the lock is released before writing.
+ *
+ * @param lock cache mutex lock
+ */
+static void saveIndexLater(std::unique_lock<std::mutex>& lock) {
+    MediaInformationCacheIndexSnapshot snapshot;
+
+    cacheIndexDirty = true;
+
+    if (snapshotIndex(snapshot, false)) {
+        lock.unlock();
+        writeIndex(snapshot);
+    }
+}
+
+/**
+ * Loads entries from the index file. Must be called while holding the cache mutex.
+ */
+static bool loadIndex() {
+    std::ifstream index(cacheIndexPath, std::ios::in | std::ios::binary);
+    std::string line;
+
+    if (!index.is_open()) {
+        struct stat indexStat;
+        return (stat(cacheIndexPath.c_str(), &indexStat) != 0) && (errno == ENOENT);
+    }
+
+    if (!std::getline(index, line) || line != MediaInformationCacheIndexHeader) {
+        std::cout << "Ignoring invalid media information cache index: " << cacheIndexPath << std::endl;
+        return false;
+    }
+
+    while (true) {
+        MediaInformationCacheEntry entry;
+        size_t pathLength;
+
+        if (!(index >> entry.key.device >> entry.key.inode >> entry.key.size >> entry.key.modificationSeconds >> entry.key.modificationNanoseconds >> pathLength)) {
+            break;
+        }
+
+        index.get();
+        entry.path.resize(pathLength);
+        if (!index.read(&entry.path[0], pathLength)) {
+            break;
+        }
+
+        index.get();
+        if (!std::getline(index, entry.json)) {
+            break;
+        }
+
+        insertEntry(std::move(entry));
+    }
+
+    return true;
+}
+
+void ffmpegkit::MediaInformationCache::setCacheSize(const int newCacheSize) {
+    std::unique_lock<std::mutex> lock(cacheMutex, std::defer_lock);
+    lock.lock();
+
+    cacheSize = (newCacheSize > 0) ? newCacheSize : 0;
+    trimEntries();
+    saveIndexLater(lock);
+}
+
+int ffmpegkit::MediaInformationCache::getCacheSize() {
+    std::unique_lock<std::mutex> lock(cacheMutex, std::defer_lock);
+    lock.lock();
+
+    return cacheSize;
+}
+
+bool ffmpegkit::MediaInformationCache::setIndexPath(const std::string& indexPath) {
+    std::unique_lock<std::mutex> lock(cacheMutex, std::defer_lock);
+    MediaInformationCacheIndexSnapshot snapshot;
+
+    lock.lock();
+
+    // WRITE PENDING CHANGES TO THE PREVIOUS INDEX
+    if (snapshotIndex(snapshot, true)) {
+        lock.unlock();
+        writeIndex(snapshot);
+        lock.lock();
+    }
+
+    cacheIndexPath = indexPath;
+    cacheIndexDirty = false;
+    if (cacheIndexPath.empty()) {
+        return true;
+    }
+
+    return loadIndex();
+}
+
+std::shared_ptr<ffmpegkit::MediaInformation> ffmpegkit::MediaInformationCache::get(const std::string& path) {
+    std::unique_lock<std::mutex> lock(cacheMutex, std::defer_lock);
+    MediaInformationCacheKey key;
+    bool keyFound = statKey(path, key);
+
+    lock.lock();
+
+    if (cacheSize == 0) {
+        return nullptr;
+    }
+
+    auto entry = cacheMap.find(path);
+    if (entry == cacheMap.end()) {
+        cacheMissCount++;
+        return nullptr;
+    }
+
+    auto listEntry = entry->second;
+    if (!keyFound || !(listEntry->key == key)) {
+
+        // FILE CHANGED OR REMOVED SINCE IT WAS CACHED
+        removeEntry(listEntry);
+        cacheMissCount++;
+        saveIndexLater(lock);
+        return nullptr;
+    }
+
+    if (listEntry->mediaInformation == nullptr) {
+        listEntry->mediaInformation = ffmpegkit::MediaInformationJsonParser::from(listEntry->json);
+        if (listEntry->mediaInformation == nullptr) {
+            removeEntry(listEntry);
+            cacheMissCount++;
+            saveIndexLater(lock);
+            return nullptr;
+        }
+    }
+
+    cacheList.splice(cacheList.begin(), cacheList, listEntry);
+    cacheHitCount++;
+
+    // EVERY SESSION RECEIVES ITS OWN COPY, THE CACHED DOCUMENT IS ONLY READ
+    const std::shared_ptr<ffmpegkit::MediaInformation> mediaInformation = listEntry->mediaInformation;
+    lock.unlock();
+
+    return copyMediaInformation(mediaInformation);
+}
+
+void ffmpegkit::MediaInformationCache::put(const std::string& path, const std::shared_ptr<ffmpegkit::MediaInformation> mediaInformation) {
+    std::unique_lock<std::mutex> lock(cacheMutex, std::defer_lock);
+    MediaInformationCacheEntry entry;
+
+    if (mediaInformation == nullptr || !statKey(path, entry.key)) {
+        return;
+    }
+
+    entry.path = path;
+    entry.mediaInformation = copyMediaInformation(mediaInformation);
+    if (entry.mediaInformation == nullptr) {
+        return;
+    }
+
+    lock.lock();
+
+    if (cacheSize > 0) {
+        insertEntry(std::move(entry));
+        saveIndexLater(lock);
+    }
+}
+
+void ffmpegkit::MediaInformationCache::invalidate(const std::string& path) {
+    std::unique_lock<std::mutex> lock(cacheMutex, std::defer_lock);
+    lock.lock();
+
+    auto entry = cacheMap.find(path);
+    if (entry != cacheMap.end()) {
+        removeEntry(entry->second);
+        saveIndexLater(lock);
+    }
+}
+
+void ffmpegkit::MediaInformationCache::invalidateAll() {
+    std::unique_lock<std::mutex> lock(cacheMutex, std::defer_lock);
+    lock.lock();
+
+    cacheMap.clear();
+    cacheList.clear();
+    saveIndexLater(lock);
+}
+
+void ffmpegkit::MediaInformationCache::flush() {
+    std::unique_lock<std::mutex> lock(cacheMutex, std::defer_lock);
+    MediaInformationCacheIndexSnapshot snapshot;
+
+    lock.lock();
+
+    if (snapshotIndex(snapshot, true)) {
+        lock.unlock();
+        writeIndex(snapshot);
+    }
+}
+
+long ffmpegkit::MediaInformationCache::getHitCount() {
+    return cacheHitCount;
+}
+
+long ffmpegkit::MediaInformationCache::getMissCount() {
+    return cacheMissCount;
+}
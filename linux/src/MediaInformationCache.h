@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2022 Taner Sener
+ *
+ * This file is part of FFmpegKit.
+ *
+ * FFmpegKit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpegKit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpegKit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FFMPEG_KIT_MEDIA_INFORMATION_CACHE_H
+#define FFMPEG_KIT_MEDIA_INFORMATION_CACHE_H
+
+#include "MediaInformation.h"
+#include <memory>
+#include <string>
+
+namespace ffmpegkit {
+
+    /**
+     * <p>Cache of media information extracted for local files.
+     *
+     * <p>When enabled, media information sessions created with default arguments, like the ones created
+     * by <code>FFprobeKit::getMediaInformation</code> methods, return cached media information without
+     * probing the file again. Entries are keyed by path and validated against the device, inode, size
+     * and modification time of the file, so a file that changes on disk is probed again.
+     *
+     * <p>The cache is disabled by default.
+     */
+    class MediaInformationCache {
+        public:
+
+            /**
+             * <p>Sets the maximum number of entries kept in the cache. Least recently used entries are
+             * removed when the cache is full.
+             *
+             * <p>Setting the size to zero disables the cache and removes all entries.
+             *
+             * @param cacheSize maximum number of entries
+             */
+            static void setCacheSize(const int cacheSize);
+
+            /**
+             * Returns the maximum number of entries kept in the cache.
+             *
+             * @return maximum number of entries, zero if the cache is disabled
+             */
+            static int getCacheSize();
+
+            /**
+             * <p>Sets the file used to persist cache entries. Existing entries in the file are loaded
+             * immediately. Changes are written back at most once every five seconds, when the cache is
+             * changed after that interval, and whenever flush is called. Pending changes for the previous
+             * file are written before switching files.
+             *
+             * <p>Loaded entries are subject to the cache size, so the size should be set before calling
+             * this method. Passing an empty path stops persisting entries, it does not delete the file.
+             *
+             * @param indexPath index file path
+             * @return true if the index file is loaded or does not exist yet, false if it is not readable
+             */
+            static bool setIndexPath(const std::string& indexPath);
+
+            /**
+             * Writes pending cache changes to the index file. Applications that persist the cache should
+             * call it before exiting, otherwise changes made in the last few seconds are lost.
+             */
+            static void flush();
+
+            /**
+             * Returns the media information cached for the given path, if the file has not changed since
+             * it was cached. Each call returns a new copy, so changes made to it are not seen by other
+             * callers and are not stored in the cache.
+             *
+             * @param path file path
+             * @return copy of the cached media information or nullptr if there is no valid entry for the path
+             */
+            static std::shared_ptr<ffmpegkit::MediaInformation> get(const std::string& path);
+
+            /**
+             * Stores a copy of the media information for the given path. Paths that don't point to a
+             * local file are not cached.
+             *
+             * @param path file path
+             * @param mediaInformation media information extracted for the file
+             */
+            static void put(const std::string& path, const std::shared_ptr<ffmpegkit::MediaInformation> mediaInformation);
+
+            /**
+             * Removes the entry cached for the given path.
+             *
+             * @param path file path
+             */
+            static void invalidate(const std::string& path);
+
+            /**
+             * Removes all cached entries.
+             */
+            static void invalidateAll();
+
+            /**
+             * Returns the number of lookups answered from the cache.
+             *
+             * @return number of cache hits
+             */
+            static long getHitCount();
+
+            /**
+             * Returns the number of lookups that required probing the file.
+             *
+             * @return number of cache misses
+             */
+            static long getMissCount();
+
+    };
+
+}
+
+#endif // FFMPEG_KIT_MEDIA_INFORMATION_CACHE_H
@@ -45,31 +45,45 @@ std::shared_ptr<ffmpegkit::MediaInformation> ffmpegkit::MediaInformationJsonPars
     if (document->HasParseError()) {
         throw std::runtime_error(GetParseError_En(document->GetParseError()));
     } else {
-        std::shared_ptr<std::vector<std::shared_ptr<ffmpegkit::StreamInformation>>> streams = std::make_shared<std::vector<std::shared_ptr<ffmpegkit::StreamInformation>>>();
-        std::shared_ptr<std::vector<std::shared_ptr<ffmpegkit::Chapter>>> chapters = std::make_shared<std::vector<std::shared_ptr<ffmpegkit::Chapter>>>();
+        return fromDocument(document);
+    }
+}
+
+std::shared_ptr<ffmpegkit::MediaInformation> ffmpegkit::MediaInformationJsonParser::fromDocument(std::shared_ptr<rapidjson::Document> document) {
+    std::shared_ptr<std::vector<std::shared_ptr<ffmpegkit::StreamInformation>>> streams = std::make_shared<std::vector<std::shared_ptr<ffmpegkit::StreamInformation>>>();
+    std::shared_ptr<std::vector<std::shared_ptr<ffmpegkit::Chapter>>> chapters = std::make_shared<std::vector<std::shared_ptr<ffmpegkit::Chapter>>>();
 
-        if (document->HasMember(MediaInformationJsonParserKeyStreams)) {
-            rapidjson::Value& streamArray = (*document.get())[MediaInformationJsonParserKeyStreams];
-            if (streamArray.IsArray()) {
-                for (rapidjson::SizeType i = 0; i < streamArray.Size(); i++) {
-                    auto stream = std::make_shared<rapidjson::Value>();
-                    *stream = streamArray[i];
-                    streams->push_back(std::make_shared<ffmpegkit::StreamInformation>(stream));
-                }
+    if (document->HasMember(MediaInformationJsonParserKeyStreams)) {
+        rapidjson::Value& streamArray = (*document.get())[MediaInformationJsonParserKeyStreams];
+        if (streamArray.IsArray()) {
+            for (rapidjson::SizeType i = 0; i < streamArray.Size(); i++) {
+                // STREAMS SHARE OWNERSHIP OF THE DOCUMENT INSTEAD OF COPYING THEIR VALUES
+                std::shared_ptr<rapidjson::Value> stream(document, &streamArray[i]);
+                streams->push_back(std::make_shared<ffmpegkit::StreamInformation>(stream));
             }
         }
+    }
 
-        if (document->HasMember(MediaInformationJsonParserKeyChapters)) {
-            rapidjson::Value& chapterArray = (*document.get())[MediaInformationJsonParserKeyChapters];
-            if (chapterArray.IsArray()) {
-                for (rapidjson::SizeType i = 0; i < chapterArray.Size(); i++) {
-                    auto chapter = std::make_shared<rapidjson::Value>();
-                    *chapter = chapterArray[i];
-                    chapters->push_back(std::make_shared<ffmpegkit::Chapter>(chapter));
-                }
+    if (document->HasMember(MediaInformationJsonParserKeyChapters)) {
+        rapidjson::Value& chapterArray = (*document.get())[MediaInformationJsonParserKeyChapters];
+        if (chapterArray.IsArray()) {
+            for (rapidjson::SizeType i = 0; i < chapterArray.Size(); i++) {
+                std::shared_ptr<rapidjson::Value> chapter(document, &chapterArray[i]);
+                chapters->push_back(std::make_shared<ffmpegkit::Chapter>(chapter));
             }
         }
+    }
 
-        return std::make_shared<ffmpegkit::MediaInformation>(std::static_pointer_cast<rapidjson::Value>(document), streams, chapters);
+    return std::make_shared<ffmpegkit::MediaInformation>(std::static_pointer_cast<rapidjson::Value>(document), streams, chapters);
+}
+
+rapidjson::Value* ffmpegkit::MediaInformationJsonParser::findMember(rapidjson::Value* object, const char* key) {
+    if (object != nullptr && object->IsObject()) {
+        rapidjson::Value::MemberIterator member = object->FindMember(key);
+        if (member != object->MemberEnd()) {
+            return &member->value;
+        }
     }
+
+    return nullptr;
 }
@@ -48,6 +48,24 @@ namespace ffmpegkit {
              */
             static std::shared_ptr<ffmpegkit::MediaInformation> fromWithError(const std::string& ffprobeJsonOutput);
 
+            /**
+             * Extracts <code>MediaInformation</code> from the given document, which must have the same layout as
+             * FFprobe's json output.
+             *
+             * @param document document that includes format, streams and chapters properties
+             * @return created MediaInformation instance
+             */
+            static std::shared_ptr<ffmpegkit::MediaInformation> fromDocument(std::shared_ptr<rapidjson::Document> document);
+
+            /**
+             * Finds a member of a json object without copying it.
+             *
+             * @param object json object, may be nullptr
+             * @param key member key
+             * @return pointer to the member inside the object or nullptr if the object does not have the member
+             */
+            static rapidjson::Value* findMember(rapidjson::Value* object, const char* key);
+
     };
 
 }
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2022 Taner Sener
+ *
+ * This file is part of FFmpegKit.
+ *
+ * FFmpegKit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpegKit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpegKit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+extern "C" {
+    #include "libavcodec/avcodec.h"
+    #include "libavformat/avformat.h"
+    #include "libavutil/channel_layout.h"
+    #include "libavutil/pixdesc.h"
+}
+#include "MediaInformationJsonParser.h"
+#include "MediaInformationNativeParser.h"
+
+typedef rapidjson::Document::AllocatorType Allocator;
+
+static void addInteger(rapidjson::Value& object, const char* key, const int64_t value, Allocator& allocator) {
+    rapidjson::Value integerValue(value);
+    object.AddMember(rapidjson::StringRef(key), integerValue, allocator);
+}
+
+static void addString(rapidjson::Value& object, const char* key, const char* value, Allocator& allocator) {
+    rapidjson::Value stringValue(value, allocator);
+    object.AddMember(rapidjson::StringRef(key), stringValue, allocator);
+}
+
+static void addRational(rapidjson::Value& object, const char* key, const AVRational value, const char separator, Allocator& allocator) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%d%c%d", value.num, separator, value.den);
+    addString(object, key, buffer, allocator);
+}
+
+static void addNumberString(rapidjson::Value& object, const char* key, const int64_t value, Allocator& allocator) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%" PRId64, value);
+    addString(object, key, buffer, allocator);
+}
+
+/**
+ * Adds a timestamp the way FFprobe prints it, in seconds. Undefined timestamps are skipped.
+ */
+static void addTime(rapidjson::Value& object, const char* key, const int64_t timestamp, const AVRational timeBase, Allocator& allocator) {
+    if (timestamp != AV_NOPTS_VALUE) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%f", timestamp * av_q2d(timeBase));
+        addString(object, key, buffer, allocator);
+    }
+}
+
+static void addTimestamp(rapidjson::Value& object, const char* key, const int64_t timestamp, Allocator& allocator) {
+    if (timestamp != AV_NOPTS_VALUE) {
+        addInteger(object, key, timestamp, allocator);
+    }
+}
+
+static void addTags(rapidjson::Value& object, const AVDictionary* metadata, Allocator& allocator) {
+    if (metadata != NULL) {
+        const AVDictionaryEntry* tag = NULL;
+        rapidjson::Value tags(rapidjson::kObjectType);
+
+        while ((tag = av_dict_get(metadata, "", tag, AV_DICT_IGNORE_SUFFIX))) {
+            rapidjson::Value tagKey(tag->key, allocator);
+            rapidjson::Value tagValue(tag->value, allocator);
+            tags.AddMember(tagKey, tagValue, allocator);
+        }
+
+        object.AddMember(rapidjson::StringRef(ffmpegkit::MediaInformation::KeyTags), tags, allocator);
+    }
+}
+
+static void addDisposition(rapidjson::Value& object, const int disposition, Allocator& allocator) {
+    static const struct {
+        int flag;
+        const char* name;
+    } dispositionNames[] = {
+        { AV_DISPOSITION_DEFAULT,          "default" },
+        { AV_DISPOSITION_DUB,              "dub" },
+        { AV_DISPOSITION_ORIGINAL,         "original" },
+        { AV_DISPOSITION_COMMENT,          "comment" },
+        { AV_DISPOSITION_LYRICS,           "lyrics" },
+        { AV_DISPOSITION_KARAOKE,          "karaoke" },
+        { AV_DISPOSITION_FORCED,           "forced" },
+        { AV_DISPOSITION_HEARING_IMPAIRED, "hearing_impaired" },
+        { AV_DISPOSITION_VISUAL_IMPAIRED,  "visual_impaired" },
+        { AV_DISPOSITION_CLEAN_EFFECTS,    "clean_effects" },
+        { AV_DISPOSITION_ATTACHED_PIC,     "attached_pic" },
+        { AV_DISPOSITION_TIMED_THUMBNAILS, "timed_thumbnails" },
+        { AV_DISPOSITION_CAPTIONS,         "captions" },
+        { AV_DISPOSITION_DESCRIPTIONS,     "descriptions" },
+        { AV_DISPOSITION_METADATA,         "metadata" },
+        { AV_DISPOSITION_DEPENDENT,        "dependent" },
+        { AV_DISPOSITION_STILL_IMAGE,      "still_image" }
+    };
+    rapidjson::Value dispositionValue(rapidjson::kObjectType);
+
+    for (const auto& dispositionName : dispositionNames) {
+        addInteger(dispositionValue, dispositionName.name, (disposition & dispositionName.flag) ? 1 : 0, allocator);
+    }
+
+    object.AddMember(rapidjson::StringRef("disposition"), dispositionValue, allocator);
+}
+
+static void addFormat(rapidjson::Value& root, AVFormatContext* formatContext, Allocator& allocator) {
+    rapidjson::Value format(rapidjson::kObjectType);
+    const int64_t size = formatContext->pb ? avio_size(formatContext->pb) : -1;
+
+    addString(format, ffmpegkit::MediaInformation::KeyFilename, formatContext->url ? formatContext->url : "", allocator);
+    addInteger(format, "nb_streams", formatContext->nb_streams, allocator);
+    addInteger(format, "nb_programs", formatContext->nb_programs, allocator);
+    addString(format, ffmpegkit::MediaInformation::KeyFormat, formatContext->iformat->name, allocator);
+    if (formatContext->iformat->long_name) {
+        addString(format, ffmpegkit::MediaInformation::KeyFormatLong, formatContext->iformat->long_name, allocator);
+    }
+    addTime(format, ffmpegkit::MediaInformation::KeyStartTime, formatContext->start_time, AV_TIME_BASE_Q, allocator);
+    addTime(format, ffmpegkit::MediaInformation::KeyDuration, formatContext->duration, AV_TIME_BASE_Q, allocator);
+    if (size >= 0) {
+        addNumberString(format, ffmpegkit::MediaInformation::KeySize, size, allocator);
+    }
+    if (formatContext->bit_rate > 0) {
+        addNumberString(format, ffmpegkit::MediaInformation::KeyBitRate, formatContext->bit_rate, allocator);
+    }
+    addInteger(format, "probe_score", formatContext->probe_score, allocator);
+    addTags(format, formatContext->metadata, allocator);
+
+    root.AddMember(rapidjson::StringRef(ffmpegkit::MediaInformation::KeyFormatProperties), format, allocator);
+}
+
+static void addStream(rapidjson::Value& streams, AVFormatContext* formatContext, AVStream* stream, Allocator& allocator) {
+    rapidjson::Value streamValue(rapidjson::kObjectType);
+    AVCodecParameters* parameters = stream->codecpar;
+    const AVCodecDescriptor* descriptor = avcodec_descriptor_get(parameters->codec_id);
+    const char* profile = avcodec_profile_name(parameters->codec_id, parameters->profile);
+    const char* mediaType = av_get_media_type_string(parameters->codec_type);
+    const char* name;
+    char buffer[128];
+
+    addInteger(streamValue, ffmpegkit::StreamInformation::KeyIndex, stream->index, allocator);
+    if (descriptor) {
+        addString(streamValue, ffmpegkit::StreamInformation::KeyCodec, descriptor->name, allocator);
+        addString(streamValue, ffmpegkit::StreamInformation::KeyCodecLong, descriptor->long_name ? descriptor->long_name : "unknown", allocator);
+    }
+    if (profile) {
+        addString(streamValue, "profile", profile, allocator);
+    } else if (parameters->profile != FF_PROFILE_UNKNOWN) {
+        addNumberString(streamValue, "profile", parameters->profile, allocator);
+    }
+    if (mediaType) {
+        addString(streamValue, ffmpegkit::StreamInformation::KeyType, mediaType, allocator);
+    }
+
+    av_fourcc_make_string(buffer, parameters->codec_tag);
+    addString(streamValue, "codec_tag_string", buffer, allocator);
+    snprintf(buffer, sizeof(buffer), "0x%04" PRIx32, parameters->codec_tag);
+    addString(streamValue, "codec_tag", buffer, allocator);
+
+    switch (parameters->codec_type) {
+        case AVMEDIA_TYPE_VIDEO: {
+            AVRational sampleAspectRatio = av_guess_sample_aspect_ratio(formatContext, stream, NULL);
+
+            addInteger(streamValue, ffmpegkit::StreamInformation::KeyWidth, parameters->width, allocator);
+            addInteger(streamValue, ffmpegkit::StreamInformation::KeyHeight, parameters->height, allocator);
+            addInteger(streamValue, "has_b_frames", parameters->video_delay, allocator);
+            if (sampleAspectRatio.num) {
+                AVRational displayAspectRatio;
+                av_reduce(&displayAspectRatio.num, &displayAspectRatio.den,
+                          parameters->width  * (int64_t)sampleAspectRatio.num,
+                          parameters->height * (int64_t)sampleAspectRatio.den,
+                          1024*1024);
+                addRational(streamValue, ffmpegkit::StreamInformation::KeySampleAspectRatio, sampleAspectRatio, ':', allocator);
+                addRational(streamValue, ffmpegkit::StreamInformation::KeyDisplayAspectRatio, displayAspectRatio, ':', allocator);
+            }
+            if ((name = av_get_pix_fmt_name((enum AVPixelFormat)parameters->format))) {
+                addString(streamValue, ffmpegkit::StreamInformation::KeyFormat, name, allocator);
+            }
+            addInteger(streamValue, "level", parameters->level, allocator);
+            if (parameters->color_range != AVCOL_RANGE_UNSPECIFIED && (name = av_color_range_name(parameters->color_range))) {
+                addString(streamValue, "color_range", name, allocator);
+            }
+            if (parameters->color_space != AVCOL_SPC_UNSPECIFIED && (name = av_color_space_name(parameters->color_space))) {
+                addString(streamValue, "color_space", name, allocator);
+            }
+            if (parameters->color_trc != AVCOL_TRC_UNSPECIFIED && (name = av_color_transfer_name(parameters->color_trc))) {
+                addString(streamValue, "color_transfer", name, allocator);
+            }
+            if (parameters->color_primaries != AVCOL_PRI_UNSPECIFIED && (name = av_color_primaries_name(parameters->color_primaries))) {
+                addString(streamValue, "color_primaries", name, allocator);
+            }
+            if (parameters->chroma_location != AVCHROMA_LOC_UNSPECIFIED && (name = av_chroma_location_name(parameters->chroma_location))) {
+                addString(streamValue, "chroma_location", name, allocator);
+            }
+            switch (parameters->field_order) {
+                case AV_FIELD_PROGRESSIVE: addString(streamValue, "field_order", "progressive", allocator); break;
+                case AV_FIELD_TT: addString(streamValue, "field_order", "tt", allocator); break;
+                case AV_FIELD_BB: addString(streamValue, "field_order", "bb", allocator); break;
+                case AV_FIELD_TB: addString(streamValue, "field_order", "tb", allocator); break;
+                case AV_FIELD_BT: addString(streamValue, "field_order", "bt", allocator); break;
+                default: break;
+            }
+        }
+        break;
+        case AVMEDIA_TYPE_AUDIO: {
+            if ((name = av_get_sample_fmt_name((enum AVSampleFormat)parameters->format))) {
+                addString(streamValue, ffmpegkit::StreamInformation::KeySampleFormat, name, allocator);
+            }
+            addNumberString(streamValue, ffmpegkit::StreamInformation::KeySampleRate, parameters->sample_rate, allocator);
+            addInteger(streamValue, "channels", parameters->ch_layout.nb_channels, allocator);
+            if (parameters->ch_layout.order != AV_CHANNEL_ORDER_UNSPEC) {
+                av_channel_layout_describe(&parameters->ch_layout, buffer, sizeof(buffer));
+                addString(streamValue, ffmpegkit::StreamInformation::KeyChannelLayout, buffer, allocator);
+            }
+            addInteger(streamValue, "bits_per_sample", av_get_bits_per_sample(parameters->codec_id), allocator);
+            addInteger(streamValue, "initial_padding", parameters->initial_padding, allocator);
+        }
+        break;
+        case AVMEDIA_TYPE_SUBTITLE: {
+            if (parameters->width) {
+                addInteger(streamValue, ffmpegkit::StreamInformation::KeyWidth, parameters->width, allocator);
+            }
+            if (parameters->height) {
+                addInteger(streamValue, ffmpegkit::StreamInformation::KeyHeight, parameters->height, allocator);
+            }
+        }
+        break;
+        default:
+        break;
+    }
+
+    if (formatContext->iformat->flags & AVFMT_SHOW_IDS) {
+        snprintf(buffer, sizeof(buffer), "0x%x", stream->id);
+        addString(streamValue, "id", buffer, allocator);
+    }
+    addRational(streamValue, ffmpegkit::StreamInformation::KeyRealFrameRate, stream->r_frame_rate, '/', allocator);
+    addRational(streamValue, ffmpegkit::StreamInformation::KeyAverageFrameRate, stream->avg_frame_rate, '/', allocator);
+    addRational(streamValue, ffmpegkit::StreamInformation::KeyTimeBase, stream->time_base, '/', allocator);
+    addTimestamp(streamValue, "start_pts", stream->start_time, allocator);
+    addTime(streamValue, "start_time", stream->start_time, stream->time_base, allocator);
+    addTimestamp(streamValue, "duration_ts", stream->duration, allocator);
+    addTime(streamValue, "duration", stream->duration, stream->time_base, allocator);
+    if (parameters->bit_rate > 0) {
+        addNumberString(streamValue, ffmpegkit::StreamInformation::KeyBitRate, parameters->bit_rate, allocator);
+    }
+    if (parameters->bits_per_raw_sample > 0) {
+        addNumberString(streamValue, "bits_per_raw_sample", parameters->bits_per_raw_sample, allocator);
+    }
+    if (stream->nb_frames) {
+        addNumberString(streamValue, "nb_frames", stream->nb_frames, allocator);
+    }
+    if (parameters->extradata_size > 0) {
+        addInteger(streamValue, "extradata_size", parameters->extradata_size, allocator);
+    }
+    addDisposition(streamValue, stream->disposition, allocator);
+    addTags(streamValue, stream->metadata, allocator);
+
+    streams.PushBack(streamValue, allocator);
+}
+
+static void addChapter(rapidjson::Value& chapters, AVChapter* chapter, Allocator& allocator) {
+    rapidjson::Value chapterValue(rapidjson::kObjectType);
+
+    addInteger(chapterValue, ffmpegkit::Chapter::KeyId, chapter->id, allocator);
+    addRational(chapterValue, ffmpegkit::Chapter::KeyTimeBase, chapter->time_base, '/', allocator);
+    addInteger(chapterValue, ffmpegkit::Chapter::KeyStart, chapter->start, allocator);
+    addTime(chapterValue, ffmpegkit::Chapter::KeyStartTime, chapter->start, chapter->time_base, allocator);
+    addInteger(chapterValue, ffmpegkit::Chapter::KeyEnd, chapter->end, allocator);
+    addTime(chapterValue, ffmpegkit::Chapter::KeyEndTime, chapter->end, chapter->time_base, allocator);
+    addTags(chapterValue, chapter->metadata, allocator);
+
+    chapters.PushBack(chapterValue, allocator);
+}
+
+std::shared_ptr<ffmpegkit::MediaInformation> ffmpegkit::MediaInformationNativeParser::from(AVFormatContext* formatContext) {
+    std::shared_ptr<rapidjson::Document> document = std::make_shared<rapidjson::Document>();
+    Allocator& allocator = document->GetAllocator();
+    rapidjson::Value streams(rapidjson::kArrayType);
+    rapidjson::Value chapters(rapidjson::kArrayType);
+
+    document->SetObject();
+
+    for (unsigned int i = 0; i < formatContext->nb_streams; i++) {
+        addStream(streams, formatContext, formatContext->streams[i], allocator);
+    }
+    for (unsigned int i = 0; i < formatContext->nb_chapters; i++) {
+        addChapter(chapters, formatContext->chapters[i], allocator);
+    }
+
+    document->AddMember(rapidjson::StringRef("streams"), streams, allocator);
+    document->AddMember(rapidjson::StringRef("chapters"), chapters, allocator);
+    addFormat(*document, formatContext, allocator);
+
+    return ffmpegkit::MediaInformationJsonParser::fromDocument(document);
+}
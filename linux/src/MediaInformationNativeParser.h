@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2022 Taner Sener
+ *
+ * This file is part of FFmpegKit.
+ *
+ * FFmpegKit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpegKit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpegKit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FFMPEG_KIT_MEDIA_INFORMATION_NATIVE_PARSER_H
+#define FFMPEG_KIT_MEDIA_INFORMATION_NATIVE_PARSER_H
+
+#include "MediaInformation.h"
+#include <memory>
+
+struct AVFormatContext;
+
+namespace ffmpegkit {
+
+    /**
+     * A parser that constructs MediaInformation directly from an opened <code>AVFormatContext</code>,
+     * without generating and parsing FFprobe's json output.
+     *
+     * <p>Properties use the same names and types FFprobe uses in its json output. Properties that
+     * FFprobe can only report after opening a decoder, like <code>coded_width</code> or
+     * <code>refs</code>, are not included.
+     */
+    class MediaInformationNativeParser {
+        public:
+
+            /**
+             * Extracts <code>MediaInformation</code> from the given format context. Stream information must
+             * already be read using <code>avformat_find_stream_info</code>.
+             *
+             * @param formatContext opened format context
+             * @return created MediaInformation instance
+             */
+            static std::shared_ptr<ffmpegkit::MediaInformation> from(AVFormatContext* formatContext);
+
+    };
+
+}
+
+#endif // FFMPEG_KIT_MEDIA_INFORMATION_NATIVE_PARSER_H
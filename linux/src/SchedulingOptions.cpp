@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2022 Taner Sener
+ *
+ * This file is part of FFmpegKit.
+ *
+ * FFmpegKit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpegKit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpegKit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SchedulingOptions.h"
+
+ffmpegkit::SchedulingOptions::SchedulingOptions() : _priority{PriorityNormal}, _deadline{0}, _throttledThreadCount{0} {
+}
+
+ffmpegkit::SchedulingOptions::SchedulingOptions(const int priority, const long deadline, const int throttledThreadCount) :
+    _priority{priority}, _deadline{deadline}, _throttledThreadCount{throttledThreadCount} {
+}
+
+int ffmpegkit::SchedulingOptions::getPriority() const {
+    return _priority;
+}
+
+long ffmpegkit::SchedulingOptions::getDeadline() const {
+    return _deadline;
+}
+
+int ffmpegkit::SchedulingOptions::getThrottledThreadCount() const {
+    return _throttledThreadCount;
+}
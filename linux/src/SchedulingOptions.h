@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2022 Taner Sener
+ *
+ * This file is part of FFmpegKit.
+ *
+ * FFmpegKit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpegKit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpegKit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FFMPEG_KIT_SCHEDULING_OPTIONS_H
+#define FFMPEG_KIT_SCHEDULING_OPTIONS_H
+
+namespace ffmpegkit {
+
+    /**
+     * <p>Defines how an asynchronous session is scheduled when it has to wait for a free worker.
+     *
+     * <p>Queued sessions with a higher priority start first. Sessions with the same priority start in
+     * deadline order and sessions without a deadline start after them, in submission order.
+     */
+    class SchedulingOptions {
+        public:
+            static constexpr int PriorityLow = -10;
+            static constexpr int PriorityNormal = 0;
+            static constexpr int PriorityHigh = 10;
+
+            /**
+             * Creates options with normal priority, no deadline and no throttling.
+             */
+            SchedulingOptions();
+
+            /**
+             * Creates new scheduling options.
+             *
+             * @param priority             session priority, higher values start first
+             * @param deadline             time in milliseconds after session creation that the session
+             * should be started by, zero for no deadline
+             * @param throttledThreadCount number of threads the session uses when it starts while
+             * sessions with a higher priority are running or waiting, zero disables throttling
+             */
+            SchedulingOptions(const int priority, const long deadline, const int throttledThreadCount);
+
+            int getPriority() const;
+            long getDeadline() const;
+            int getThrottledThreadCount() const;
+
+        private:
+            int _priority;
+            long _deadline;
+            int _throttledThreadCount;
+    };
+
+}
+
+#endif // FFMPEG_KIT_SCHEDULING_OPTIONS_H
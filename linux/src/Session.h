@@ -24,10 +24,12 @@
 #include "LogCallback.h"
 #include "LogRedirectionStrategy.h"
 #include "ReturnCode.h"
+#include "SchedulingOptions.h"
 #include "SessionState.h"
 #include <string>
 #include <chrono>
 #include <list>
+#include <memory>
 
 namespace ffmpegkit {
 
@@ -80,6 +82,28 @@ namespace ffmpegkit {
              */
             virtual long getDuration() const = 0;
 
+            /**
+             * Returns the time this session is submitted to an async executor queue.
+             *
+             * @return session queue time, empty if the session is not executed asynchronously
+             */
+            virtual std::chrono::time_point<std::chrono::system_clock> getQueueTime() const = 0;
+
+            /**
+             * Returns the time this session waited in an async executor queue before it started.
+             *
+             * @return time spent in the queue in milliseconds or zero (0) if the session is not queued
+             * or not started yet
+             */
+            virtual long getQueueDuration() const = 0;
+
+            /**
+             * Returns the scheduling options used when this session is executed asynchronously.
+             *
+             * @return scheduling options
+             */
+            virtual ffmpegkit::SchedulingOptions getSchedulingOptions() const = 0;
+
             /**
              * Returns command arguments as a list.
              *
@@ -147,6 +171,42 @@ namespace ffmpegkit {
              */
             virtual std::string getLogsAsString() const = 0;
 
+            /**
+             * Returns log entries delivered for this session after the given cursor and moves the cursor
+             * after the last entry returned. Start with a cursor of zero. Entries that are already
+             * removed because of log retention limits are skipped.
+             *
+             * @param cursor log cursor, updated by this method
+             * @return log entries delivered after the cursor
+             */
+            virtual std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::Log>>> getLogsSince(long& cursor) const = 0;
+
+            /**
+             * Sets how many log entries this session keeps. When a limit is exceeded the oldest entries
+             * are removed. Zero means no limit.
+             *
+             * @param lineLimit maximum number of log entries
+             * @param byteLimit maximum total size of log messages in bytes
+             */
+            virtual void setLogRetention(const int lineLimit, const long byteLimit) = 0;
+
+            /**
+             * Sets the most verbose level of log entries this session stores. Entries above this level
+             * are still forwarded to log callbacks and printed, but are not kept in the session. When
+             * no callback or print is configured for them, they are dropped before they are formatted.
+             * Must be set before the session is executed.
+             *
+             * @param level most verbose level of log entries stored
+             */
+            virtual void setLogStoreLevel(const ffmpegkit::Level level) = 0;
+
+            /**
+             * Returns the most verbose level of log entries this session stores.
+             *
+             * @return most verbose level of log entries stored, LevelAVLogTrace by default
+             */
+            virtual ffmpegkit::Level getLogStoreLevel() const = 0;
+
             /**
              * Returns the log output generated while running the session.
              *
@@ -208,6 +268,11 @@ namespace ffmpegkit {
              */
             virtual void addLog(const std::shared_ptr<ffmpegkit::Log> log) = 0;
 
+            /**
+             * Marks the session as waiting in an async executor queue.
+             */
+            virtual void queue() = 0;
+
             /**
              * Starts running the session.
              */
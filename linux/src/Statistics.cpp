@@ -54,3 +54,11 @@ double ffmpegkit::Statistics::getBitrate() {
 double ffmpegkit::Statistics::getSpeed() {
     return _speed;
 }
+
+std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::StreamStatistics>>> ffmpegkit::Statistics::getStreamStatistics() {
+    return _streamStatistics;
+}
+
+void ffmpegkit::Statistics::setStreamStatistics(const std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::StreamStatistics>>> streamStatistics) {
+    _streamStatistics = streamStatistics;
+}
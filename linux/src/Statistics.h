@@ -20,7 +20,10 @@
 #ifndef FFMPEG_KIT_STATISTICS_H
 #define FFMPEG_KIT_STATISTICS_H
 
+#include "StreamStatistics.h"
 #include <stdlib.h>
+#include <list>
+#include <memory>
 
 namespace ffmpegkit {
 
@@ -40,6 +43,23 @@ namespace ffmpegkit {
             double getBitrate();
             double getSpeed();
 
+            /**
+             * Returns the statistics of the input and output streams of the session, input streams
+             * first. Stream statistics are only collected while they are enabled using
+             * <code>FFmpegKitConfig::enableStreamStatistics</code>.
+             *
+             * @return stream statistics or nullptr if stream statistics are not collected
+             */
+            std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::StreamStatistics>>> getStreamStatistics();
+
+            /**
+             * Sets the stream statistics of this entry. Invoked internally when the entry is
+             * created.
+             *
+             * @param streamStatistics stream statistics
+             */
+            void setStreamStatistics(const std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::StreamStatistics>>> streamStatistics);
+
         private:
             long _sessionId;
             int _videoFrameNumber;
@@ -49,6 +69,7 @@ namespace ffmpegkit {
             double _time;
             double _bitrate;
             double _speed;
+            std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::StreamStatistics>>> _streamStatistics;
     };
 
 }
@@ -18,6 +18,7 @@
  */
 
 #include "StreamInformation.h"
+#include "MediaInformationJsonParser.h"
 
 ffmpegkit::StreamInformation::StreamInformation(std::shared_ptr<rapidjson::Value> streamInformationValue) : _streamInformationValue{streamInformationValue} {
 }
@@ -95,37 +96,32 @@ std::shared_ptr<rapidjson::Value> ffmpegkit::StreamInformation::getTags() {
 }
 
 std::shared_ptr<std::string> ffmpegkit::StreamInformation::getStringProperty(const char* key) {
-    if (_streamInformationValue->HasMember(key)) {
-        return std::make_shared<std::string>((*_streamInformationValue)[key].GetString());
+    const rapidjson::Value* value = ffmpegkit::MediaInformationJsonParser::findMember(_streamInformationValue.get(), key);
+    if (value != nullptr) {
+        return std::make_shared<std::string>(value->GetString(), value->GetStringLength());
     } else {
         return nullptr;
     }
 }
 
 std::shared_ptr<int64_t> ffmpegkit::StreamInformation::getNumberProperty(const char* key) {
-    if (_streamInformationValue->HasMember(key)) {
-        return std::make_shared<int64_t>((*_streamInformationValue)[key].GetInt64());
+    const rapidjson::Value* value = ffmpegkit::MediaInformationJsonParser::findMember(_streamInformationValue.get(), key);
+    if (value != nullptr) {
+        return std::make_shared<int64_t>(value->GetInt64());
     } else {
         return nullptr;
     }
 }
 
 std::shared_ptr<rapidjson::Value> ffmpegkit::StreamInformation::getProperty(const char* key) {
-    if (_streamInformationValue->HasMember(key)) {
-        auto value = std::make_shared<rapidjson::Value>();
-        *value = (*_streamInformationValue)[key];
-        return value;
+    rapidjson::Value* value = ffmpegkit::MediaInformationJsonParser::findMember(_streamInformationValue.get(), key);
+    if (value != nullptr) {
+        return std::shared_ptr<rapidjson::Value>(_streamInformationValue, value);
     } else {
         return nullptr;
     }
 }
 
 std::shared_ptr<rapidjson::Value> ffmpegkit::StreamInformation::getAllProperties() {
-    if (_streamInformationValue != nullptr) {
-        auto all = std::make_shared<rapidjson::Value>();
-        *all =  (*_streamInformationValue);
-        return all;
-    } else {
-        return nullptr;
-    }
+    return _streamInformationValue;
 }
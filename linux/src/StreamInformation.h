@@ -30,6 +30,8 @@ namespace ffmpegkit {
 
     /**
      * Stream information class.
+     *
+     * <p>Values returned by property getters point into the media information document.
      */
     class StreamInformation {
         public:
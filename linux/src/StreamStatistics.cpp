@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2022 Taner Sener
+ *
+ * This file is part of FFmpegKit.
+ *
+ * FFmpegKit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpegKit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpegKit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StreamStatistics.h"
+
+ffmpegkit::StreamStatistics::StreamStatistics(const int fileIndex, const int index, const bool output, const std::string& type, const uint64_t packetsDemuxed, const uint64_t framesDecoded, const uint64_t framesFiltered, const uint64_t framesEncoded, const uint64_t packetsEncoded, const uint64_t packetsMuxed, const int64_t framesDuplicated, const int64_t framesDropped, const int queueDepth, const int64_t decodeWallTime, const int64_t decodeCpuTime, const int64_t filterWallTime, const int64_t filterCpuTime, const int64_t encodeWallTime, const int64_t encodeCpuTime, const int64_t muxWallTime, const int64_t muxCpuTime) :
+    _fileIndex{fileIndex}, _index{index}, _output{output}, _type{type}, _packetsDemuxed{packetsDemuxed}, _framesDecoded{framesDecoded}, _framesFiltered{framesFiltered}, _framesEncoded{framesEncoded}, _packetsEncoded{packetsEncoded}, _packetsMuxed{packetsMuxed}, _framesDuplicated{framesDuplicated}, _framesDropped{framesDropped}, _queueDepth{queueDepth}, _decodeWallTime{decodeWallTime}, _decodeCpuTime{decodeCpuTime}, _filterWallTime{filterWallTime}, _filterCpuTime{filterCpuTime}, _encodeWallTime{encodeWallTime}, _encodeCpuTime{encodeCpuTime}, _muxWallTime{muxWallTime}, _muxCpuTime{muxCpuTime} {
+}
+
+int ffmpegkit::StreamStatistics::getFileIndex() {
+    return _fileIndex;
+}
+
+int ffmpegkit::StreamStatistics::getIndex() {
+    return _index;
+}
+
+bool ffmpegkit::StreamStatistics::isOutput() {
+    return _output;
+}
+
+std::string ffmpegkit::StreamStatistics::getType() {
+    return _type;
+}
+
+uint64_t ffmpegkit::StreamStatistics::getPacketsDemuxed() {
+    return _packetsDemuxed;
+}
+
+uint64_t ffmpegkit::StreamStatistics::getFramesDecoded() {
+    return _framesDecoded;
+}
+
+uint64_t ffmpegkit::StreamStatistics::getFramesFiltered() {
+    return _framesFiltered;
+}
+
+uint64_t ffmpegkit::StreamStatistics::getFramesEncoded() {
+    return _framesEncoded;
+}
+
+uint64_t ffmpegkit::StreamStatistics::getPacketsEncoded() {
+    return _packetsEncoded;
+}
+
+uint64_t ffmpegkit::StreamStatistics::getPacketsMuxed() {
+    return _packetsMuxed;
+}
+
+int64_t ffmpegkit::StreamStatistics::getFramesDuplicated() {
+    return _framesDuplicated;
+}
+
+int64_t ffmpegkit::StreamStatistics::getFramesDropped() {
+    return _framesDropped;
+}
+
+int ffmpegkit::StreamStatistics::getQueueDepth() {
+    return _queueDepth;
+}
+
+int64_t ffmpegkit::StreamStatistics::getDecodeWallTime() {
+    return _decodeWallTime;
+}
+
+int64_t ffmpegkit::StreamStatistics::getDecodeCpuTime() {
+    return _decodeCpuTime;
+}
+
+int64_t ffmpegkit::StreamStatistics::getFilterWallTime() {
+    return _filterWallTime;
+}
+
+int64_t ffmpegkit::StreamStatistics::getFilterCpuTime() {
+    return _filterCpuTime;
+}
+
+int64_t ffmpegkit::StreamStatistics::getEncodeWallTime() {
+    return _encodeWallTime;
+}
+
+int64_t ffmpegkit::StreamStatistics::getEncodeCpuTime() {
+    return _encodeCpuTime;
+}
+
+int64_t ffmpegkit::StreamStatistics::getMuxWallTime() {
+    return _muxWallTime;
+}
+
+int64_t ffmpegkit::StreamStatistics::getMuxCpuTime() {
+    return _muxCpuTime;
+}
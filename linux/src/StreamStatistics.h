@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2022 Taner Sener
+ *
+ * This file is part of FFmpegKit.
+ *
+ * FFmpegKit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpegKit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpegKit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FFMPEG_KIT_STREAM_STATISTICS_H
+#define FFMPEG_KIT_STREAM_STATISTICS_H
+
+#include <stdint.h>
+#include <string>
+
+namespace ffmpegkit {
+
+    /**
+     * Statistics of a single input or output stream of an FFmpeg execute session. Counters are
+     * totals since the session started, times are in microseconds. Counters and times that do
+     * not apply to a stream, e.g. encode times of an input stream, are zero.
+     */
+    class StreamStatistics {
+        public:
+
+            StreamStatistics(const int fileIndex, const int index, const bool output, const std::string& type,
+                             const uint64_t packetsDemuxed, const uint64_t framesDecoded, const uint64_t framesFiltered,
+                             const uint64_t framesEncoded, const uint64_t packetsEncoded, const uint64_t packetsMuxed,
+                             const int64_t framesDuplicated, const int64_t framesDropped, const int queueDepth,
+                             const int64_t decodeWallTime, const int64_t decodeCpuTime,
+                             const int64_t filterWallTime, const int64_t filterCpuTime,
+                             const int64_t encodeWallTime, const int64_t encodeCpuTime,
+                             const int64_t muxWallTime, const int64_t muxCpuTime);
+
+            /**
+             * Returns the index of the input or output file this stream belongs to.
+             *
+             * @return file index
+             */
+            int getFileIndex();
+
+            /**
+             * Returns the index of this stream inside its file.
+             *
+             * @return stream index
+             */
+            int getIndex();
+
+            /**
+             * Returns whether this is an output stream.
+             *
+             * @return true for output streams, false for input streams
+             */
+            bool isOutput();
+
+            /**
+             * Returns the media type of this stream, e.g. "video" or "audio".
+             *
+             * @return media type
+             */
+            std::string getType();
+
+            uint64_t getPacketsDemuxed();
+            uint64_t getFramesDecoded();
+
+            /**
+             * Returns the number of frames sent to the filters for input streams and the number
+             * of frames received from the filters for output streams.
+             *
+             * @return number of filtered frames
+             */
+            uint64_t getFramesFiltered();
+            uint64_t getFramesEncoded();
+            uint64_t getPacketsEncoded();
+            uint64_t getPacketsMuxed();
+            int64_t getFramesDuplicated();
+            int64_t getFramesDropped();
+
+            /**
+             * Returns the number of packets waiting in the demuxer thread queue of the input file
+             * or in the muxer thread queue of the output file.
+             *
+             * @return queue depth of the file
+             */
+            int getQueueDepth();
+
+            int64_t getDecodeWallTime();
+            int64_t getDecodeCpuTime();
+            int64_t getFilterWallTime();
+            int64_t getFilterCpuTime();
+            int64_t getEncodeWallTime();
+            int64_t getEncodeCpuTime();
+            int64_t getMuxWallTime();
+            int64_t getMuxCpuTime();
+
+        private:
+            int _fileIndex;
+            int _index;
+            bool _output;
+            std::string _type;
+            uint64_t _packetsDemuxed;
+            uint64_t _framesDecoded;
+            uint64_t _framesFiltered;
+            uint64_t _framesEncoded;
+            uint64_t _packetsEncoded;
+            uint64_t _packetsMuxed;
+            int64_t _framesDuplicated;
+            int64_t _framesDropped;
+            int _queueDepth;
+            int64_t _decodeWallTime;
+            int64_t _decodeCpuTime;
+            int64_t _filterWallTime;
+            int64_t _filterCpuTime;
+            int64_t _encodeWallTime;
+            int64_t _encodeCpuTime;
+            int64_t _muxWallTime;
+            int64_t _muxCpuTime;
+    };
+
+}
+
+#endif // FFMPEG_KIT_STREAM_STATISTICS_H
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2022 Taner Sener
+ *
+ * This file is part of FFmpegKit.
+ *
+ * FFmpegKit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpegKit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpegKit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FFMPEG_KIT_STREAM_STATISTICS_CALLBACK_H
+#define FFMPEG_KIT_STREAM_STATISTICS_CALLBACK_H
+
+#include "StreamStatistics.h"
+#include <iostream>
+#include <list>
+#include <memory>
+#include <functional>
+
+namespace ffmpegkit {
+
+    /**
+     * <p>Callback that receives stream statistics generated for <code>FFmpegKit</code> sessions.
+     *
+     * @param sessionId session id
+     * @param streamStatistics statistics of the input and output streams of the session
+     */
+    typedef std::function<void(const long sessionId, const std::shared_ptr<std::list<std::shared_ptr<ffmpegkit::StreamStatistics>>> streamStatistics)> StreamStatisticsCallback;
+
+}
+
+#endif // FFMPEG_KIT_STREAM_STATISTICS_CALLBACK_H
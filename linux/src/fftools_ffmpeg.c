@@ -32,6 +32,25 @@
  *
  * ffmpeg-kit changes by ARTHENICA LTD
  *
+ * 10.2026
+ * --------------------------------------------------------
+ * - audio and video decoders run on their own threads fed by a ThreadQueue, see dec_thread_start(), can be disabled
+ *   with -nothreaded_decoding
+ * - audio and video encoders run on their own threads, see enc_thread_start(), can be disabled with
+ *   -nothreaded_encoding
+ * - filtergraph_parallel option added, filtergraphs are waited for with fg_thread_wait() before being accessed
+ * - choose_output() takes the output stream from a min-heap once all streams are started
+ * - transcode_step() waits for the demuxer threads instead of sleeping when all inputs return EAGAIN
+ * - eagain_backoff_min and eagain_backoff_max options added
+ * - demuxed packets are returned to the demuxer with ifile_release_packet()
+ * - decoder and encoder thread queues take their packets and frames from the session pools
+ * - enc_stats_write() flushes periodically instead of after every record, stats_binary option added
+ * - per stream counters and decode/filter/encode/mux stage times forwarded with forward_stream_report(),
+ *   stream_report_callback function pointer and set_stream_report_callback() setter added
+ * - trace_file option added, decoder, encoder and filter spans recorded for the session trace
+ * - option variables reset in ffmpeg_var_cleanup()
+ * - video packets sent to decoder threads carry the dts predicted by handle_input_packet()
+ *
  * 09.2023
  * --------------------------------------------------------
  * - forward_report method signature accepts pts to calculate the time
@@ -122,6 +141,7 @@
 #include "libavutil/fifo.h"
 #include "libavutil/hwcontext.h"
 #include "libavutil/internal.h"
+#include "libavutil/intfloat.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/dict.h"
 #include "libavutil/display.h"
@@ -176,6 +196,8 @@
 #include "fftools_ffmpeg.h"
 #include "fftools_cmdutils.h"
 #include "fftools_sync_queue.h"
+#include "fftools_objpool.h"
+#include "fftools_thread_queue.h"
 
 #include "libavutil/avassert.h"
 
@@ -223,6 +245,10 @@ __thread int first_report = 1;
 __thread int qp_histogram[52];
 
 void (*report_callback)(int, float, float, int64_t, double, double, double) = NULL;
+void (*stream_report_callback)(const StreamReport *, int) = NULL;
+
+/* set while a stream report callback is set, read by all threads */
+static atomic_int stage_timing;
 
 extern int opt_map(void *optctx, const char *opt, const char *arg);
 extern int opt_map_channel(void *optctx, const char *opt, const char *arg);
@@ -243,6 +269,7 @@ extern int opt_video_codec(void *optctx, const char *opt, const char *arg);
 extern int opt_sameq(void *optctx, const char *opt, const char *arg);
 extern int opt_timecode(void *optctx, const char *opt, const char *arg);
 extern int opt_vstats_file(void *optctx, const char *opt, const char *arg);
+extern int opt_trace_file(void *optctx, const char *opt, const char *arg);
 extern int opt_vstats(void *optctx, const char *opt, const char *arg);
 extern int opt_video_frames(void *optctx, const char *opt, const char *arg);
 extern int opt_old2new(void *optctx, const char *opt, const char *arg);
@@ -294,6 +321,10 @@ extern __thread long globalSessionId;
 extern void cancelSession(long sessionId);
 extern int cancelRequested(long sessionId);
 
+/* started output streams, as a min-heap on the timestamp choose_output() compares */
+static __thread OutputStream **ost_heap    = NULL;
+static __thread int            nb_ost_heap = 0;
+
 /* sub2video hack:
    Convert subtitles to video with alpha to insert them in filter graphs.
    This is a temporary solution until libavfilter gets real subtitles support.
@@ -354,6 +385,7 @@ static void sub2video_push_ref(InputStream *ist, int64_t pts)
     av_assert1(frame->data[0]);
     ist->sub2video.last_pts = frame->pts = pts;
     for (i = 0; i < ist->nb_filters; i++) {
+        fg_thread_wait(ist->filters[i]->graph);
         ret = av_buffersrc_add_frame_flags(ist->filters[i]->filter, frame,
                                            AV_BUFFERSRC_FLAG_KEEP_REF |
                                            AV_BUFFERSRC_FLAG_PUSH);
@@ -428,8 +460,10 @@ static void sub2video_heartbeat(InputStream *ist, int64_t pts)
                or if we need to initialize the system, update the
                overlayed subpicture and its start/end times */
             sub2video_update(ist2, pts2 + 1, NULL);
-        for (j = 0, nb_reqs = 0; j < ist2->nb_filters; j++)
+        for (j = 0, nb_reqs = 0; j < ist2->nb_filters; j++) {
+            fg_thread_wait(ist2->filters[j]->graph);
             nb_reqs += av_buffersrc_get_nb_failed_requests(ist2->filters[j]->filter);
+        }
         if (nb_reqs)
             sub2video_push_ref(ist2, pts2);
     }
@@ -443,6 +477,7 @@ static void sub2video_flush(InputStream *ist)
     if (ist->sub2video.end_pts < INT64_MAX)
         sub2video_update(ist, INT64_MAX, NULL);
     for (i = 0; i < ist->nb_filters; i++) {
+        fg_thread_wait(ist->filters[i]->graph);
         ret = av_buffersrc_add_frame(ist->filters[i]->filter, NULL);
         if (ret != AVERROR_EOF && ret < 0)
             av_log(NULL, AV_LOG_WARNING, "Flush the frame error.\n");
@@ -671,6 +706,7 @@ static void ffmpeg_cleanup(int ret)
 
     for (i = 0; i < nb_filtergraphs; i++) {
         FilterGraph *fg = filtergraphs[i];
+        fg_thread_stop(fg);
         avfilter_graph_free(&fg->graph);
         for (j = 0; j < fg->nb_inputs; j++) {
             InputFilter *ifilter = fg->inputs[j];
@@ -715,6 +751,16 @@ static void ffmpeg_cleanup(int ret)
 
     for (i = 0; i < nb_input_files; i++)
         ifile_close(&input_files[i]);
+    ifile_wait_packet_uninit();
+
+    /* all threads have exited, the trace is complete */
+    trace_session_uninit();
+    av_freep(&trace_filename);
+
+    av_freep(&ost_heap);
+    nb_ost_heap = 0;
+
+    objpool_session_uninit();
 
     if (vstats_file) {
         if (fclose(vstats_file))
@@ -971,6 +1017,48 @@ static void update_video_stats(OutputStream *ost, const AVPacket *pkt, int write
     fprintf(vstats_file, "type= %c\n", av_get_picture_type_char(ost->pict_type));
 }
 
+/* maximum time the stats written by enc_stats_write() stay in the AVIOContext buffer, in microseconds */
+#define ENC_STATS_FLUSH_INTERVAL 1000000
+
+/*
+ * Stats components are written as text using the format string, or with -stats_binary as
+ * little-endian fields in component order: literals are skipped, timebases are two 32-bit
+ * integers (num, den), times and bitrates are 64-bit IEEE doubles and everything else is a
+ * 64-bit integer.
+ */
+static void enc_stats_int(const EncStats *es, int64_t val)
+{
+    if (es->binary)
+        avio_wl64(es->io, val);
+    else
+        avio_printf(es->io, "%"PRId64, val);
+}
+
+static void enc_stats_uint(const EncStats *es, uint64_t val)
+{
+    if (es->binary)
+        avio_wl64(es->io, val);
+    else
+        avio_printf(es->io, "%"PRIu64, val);
+}
+
+static void enc_stats_double(const EncStats *es, double val)
+{
+    if (es->binary)
+        avio_wl64(es->io, av_double2int(val));
+    else
+        avio_printf(es->io, "%g", val);
+}
+
+static void enc_stats_tb(const EncStats *es, AVRational tb)
+{
+    if (es->binary) {
+        avio_wl32(es->io, tb.num);
+        avio_wl32(es->io, tb.den);
+    } else
+        avio_printf(es->io, "%d/%d", tb.num, tb.den);
+}
+
 void enc_stats_write(OutputStream *ost, EncStats *es,
                      const AVFrame *frame, const AVPacket *pkt,
                      uint64_t frame_num)
@@ -978,11 +1066,12 @@ void enc_stats_write(OutputStream *ost, EncStats *es,
     AVIOContext *io = es->io;
     AVRational   tb = frame ? frame->time_base : pkt->time_base;
     int64_t     pts = frame ? frame->pts : pkt->pts;
+    int64_t     now;
 
     AVRational  tbi = (AVRational){ 0, 1};
     int64_t    ptsi = INT64_MAX;
 
-    const FrameData *fd;
+    const FrameData *fd = NULL;
 
     if ((frame && frame->opaque_ref) || (pkt && pkt->opaque_ref)) {
         fd   = (const FrameData*)(frame ? frame->opaque_ref->data : pkt->opaque_ref->data);
@@ -994,55 +1083,504 @@ void enc_stats_write(OutputStream *ost, EncStats *es,
         const EncStatsComponent *c = &es->components[i];
 
         switch (c->type) {
-        case ENC_STATS_LITERAL:         avio_write (io, c->str,     c->str_len);                    continue;
-        case ENC_STATS_FILE_IDX:        avio_printf(io, "%d",       ost->file_index);               continue;
-        case ENC_STATS_STREAM_IDX:      avio_printf(io, "%d",       ost->index);                    continue;
-        case ENC_STATS_TIMEBASE:        avio_printf(io, "%d/%d",    tb.num, tb.den);                continue;
-        case ENC_STATS_TIMEBASE_IN:     avio_printf(io, "%d/%d",    tbi.num, tbi.den);              continue;
-        case ENC_STATS_PTS:             avio_printf(io, "%"PRId64,  pts);                           continue;
-        case ENC_STATS_PTS_IN:          avio_printf(io, "%"PRId64,  ptsi);                          continue;
-        case ENC_STATS_PTS_TIME:        avio_printf(io, "%g",       pts * av_q2d(tb));              continue;
-        case ENC_STATS_PTS_TIME_IN:     avio_printf(io, "%g",       ptsi == INT64_MAX ?
-                                                                    INFINITY : ptsi * av_q2d(tbi)); continue;
-        case ENC_STATS_FRAME_NUM:       avio_printf(io, "%"PRIu64,  frame_num);                     continue;
-        case ENC_STATS_FRAME_NUM_IN:    avio_printf(io, "%"PRIu64,  fd ? fd->idx : -1);             continue;
+        case ENC_STATS_LITERAL:
+            if (!es->binary)
+                avio_write(io, c->str, c->str_len);
+            continue;
+        case ENC_STATS_FILE_IDX:        enc_stats_int   (es, ost->file_index);                      continue;
+        case ENC_STATS_STREAM_IDX:      enc_stats_int   (es, ost->index);                           continue;
+        case ENC_STATS_TIMEBASE:        enc_stats_tb    (es, tb);                                   continue;
+        case ENC_STATS_TIMEBASE_IN:     enc_stats_tb    (es, tbi);                                  continue;
+        case ENC_STATS_PTS:             enc_stats_int   (es, pts);                                  continue;
+        case ENC_STATS_PTS_IN:          enc_stats_int   (es, ptsi);                                 continue;
+        case ENC_STATS_PTS_TIME:        enc_stats_double(es, pts * av_q2d(tb));                     continue;
+        case ENC_STATS_PTS_TIME_IN:     enc_stats_double(es, ptsi == INT64_MAX ?
+                                                         INFINITY : ptsi * av_q2d(tbi));            continue;
+        case ENC_STATS_FRAME_NUM:       enc_stats_uint  (es, frame_num);                            continue;
+        case ENC_STATS_FRAME_NUM_IN:    enc_stats_uint  (es, fd ? fd->idx : -1);                    continue;
         }
 
         if (frame) {
             switch (c->type) {
-            case ENC_STATS_SAMPLE_NUM:  avio_printf(io, "%"PRIu64,  ost->samples_encoded);          continue;
-            case ENC_STATS_NB_SAMPLES:  avio_printf(io, "%d",       frame->nb_samples);             continue;
+            case ENC_STATS_SAMPLE_NUM:  enc_stats_uint  (es, ost->samples_encoded);                 continue;
+            case ENC_STATS_NB_SAMPLES:  enc_stats_int   (es, frame->nb_samples);                    continue;
             default: av_assert0(0);
             }
         } else {
             switch (c->type) {
-            case ENC_STATS_DTS:         avio_printf(io, "%"PRId64,  pkt->dts);                      continue;
-            case ENC_STATS_DTS_TIME:    avio_printf(io, "%g",       pkt->dts * av_q2d(tb));         continue;
-            case ENC_STATS_PKT_SIZE:    avio_printf(io, "%d",       pkt->size);                     continue;
+            case ENC_STATS_DTS:         enc_stats_int   (es, pkt->dts);                             continue;
+            case ENC_STATS_DTS_TIME:    enc_stats_double(es, pkt->dts * av_q2d(tb));                continue;
+            case ENC_STATS_PKT_SIZE:    enc_stats_int   (es, pkt->size);                            continue;
             case ENC_STATS_BITRATE: {
                 double duration = FFMAX(pkt->duration, 1) * av_q2d(tb);
-                avio_printf(io, "%g",  8.0 * pkt->size / duration);
+                enc_stats_double(es, 8.0 * pkt->size / duration);
                 continue;
             }
             case ENC_STATS_AVG_BITRATE: {
                 double duration = pkt->dts * av_q2d(tb);
-                avio_printf(io, "%g",  duration > 0 ? 8.0 * ost->data_size_enc / duration : -1.);
+                enc_stats_double(es, duration > 0 ? 8.0 * ost->data_size_enc / duration : -1.);
                 continue;
             }
             default: av_assert0(0);
             }
         }
     }
-    avio_w8(io, '\n');
-    avio_flush(io);
+    if (!es->binary)
+        avio_w8(io, '\n');
+
+    /* the AVIOContext buffer is written out when full, flushing here only keeps
+     * the file reasonably current for anyone following it */
+    now = av_gettime_relative();
+    if (now - es->flush_time >= ENC_STATS_FLUSH_INTERVAL) {
+        avio_flush(io);
+        es->flush_time = now;
+    }
 }
 
-static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
+/* number of frames the transcode thread may have queued for an encoder thread */
+#define ENC_THREAD_QUEUE_SIZE 8
+
+/*
+ * Result of the encoder thread. ret is 0 when pkt holds an encoded packet,
+ * AVERROR_EOF when the encoder was flushed or an error code, submit tells
+ * whether the error came from avcodec_send_frame().
+ */
+typedef struct EncoderItem {
+    AVPacket *pkt;
+    int       ret;
+    int       submit;
+} EncoderItem;
+
+struct EncoderThread {
+    pthread_t       thread;
+    int             thread_started;
+
+    /* copied from the transcode thread, the encoder thread can not read thread-local options */
+    long            session_id;
+    int             update_sample_aspect_ratio;
+    AVCodecContext *enc_ctx;
+    StageTime      *encode_time;
+    Tracer         *tracer;
+    int             file_index;
+    int             index;
+
+    /* frames for the encoder, stream 0 carries frames and stream 1 the flush request */
+    ThreadQueue    *queue_in;
+    /* EncoderItems from the encoder */
+    ThreadQueue    *queue_out;
+
+    /* progress of the encoder thread, signalled through cond */
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    int             lock_initialized;
+    atomic_int      frames_taken;
+    atomic_int      items_sent;
+    atomic_int      finished;
+    int             error;
+
+    /* the fields below are used by the transcode thread only */
+    int             frames_sent;
+    int             items_received;
+    AVFrame        *frame;
+    EncoderItem    *item;
+};
+
+static void *enc_item_alloc(void)
+{
+    EncoderItem *item = av_mallocz(sizeof(*item));
+
+    if (!item)
+        return NULL;
+
+    item->pkt = av_packet_alloc();
+    if (!item->pkt)
+        av_freep(&item);
+
+    return item;
+}
+
+static void enc_item_reset(void *obj)
+{
+    EncoderItem *item = obj;
+
+    av_packet_unref(item->pkt);
+    item->ret    = 0;
+    item->submit = 0;
+}
+
+static void enc_item_free(void **obj)
+{
+    EncoderItem *item = *obj;
+
+    if (item)
+        av_packet_free(&item->pkt);
+    av_freep(obj);
+}
+
+static void enc_item_move(void *dst, void *src)
+{
+    EncoderItem *dst_item = dst;
+    EncoderItem *src_item = src;
+
+    av_packet_move_ref(dst_item->pkt, src_item->pkt);
+    dst_item->ret    = src_item->ret;
+    dst_item->submit = src_item->submit;
+}
+
+static void enc_frame_move(void *dst, void *src)
+{
+    av_frame_move_ref(dst, src);
+}
+
+static void enc_thread_progress(EncoderThread *et, atomic_int *counter)
+{
+    pthread_mutex_lock(&et->lock);
+    atomic_fetch_add(counter, 1);
+    pthread_cond_signal(&et->cond);
+    pthread_mutex_unlock(&et->lock);
+}
+
+static int enc_thread_output(EncoderThread *et, EncoderItem *item, int ret, int submit)
+{
+    item->ret    = ret;
+    item->submit = submit;
+
+    ret = tq_send(et->queue_out, 0, item);
+    if (ret < 0) {
+        enc_item_reset(item);
+        return ret;
+    }
+
+    enc_thread_progress(et, &et->items_sent);
+
+    return 0;
+}
+
+/*
+ * Encoder thread, runs the avcodec_send_frame()/avcodec_receive_packet() part
+ * of encode_frame() and returns the packets to the transcode thread.
+ */
+static void *enc_thread_main(void *arg)
+{
+    EncoderThread *et = arg;
+    AVCodecContext *enc = et->enc_ctx;
+    AVFrame *frame = NULL;
+    EncoderItem *item = NULL;
+    StageTimer timer;
+    int64_t trace_start;
+    int ret = 0;
+
+    globalSessionId = et->session_id;
+    trace_thread_init(et->tracer, "encode %d:%d", et->file_index, et->index);
+
+    frame = av_frame_alloc();
+    item  = enc_item_alloc();
+    if (!frame || !item) {
+        ret = AVERROR(ENOMEM);
+        goto finish;
+    }
+
+    while (1) {
+        int stream_idx, flush;
+
+        ret = tq_receive(et->queue_in, &stream_idx, frame);
+        if (ret == AVERROR_EOF && stream_idx >= 0)
+            continue;
+        if (ret < 0)
+            break;
+
+        flush = stream_idx == 1;
+        enc_thread_progress(et, &et->frames_taken);
+
+        /* written by reap_filters() on the transcode thread when encoding synchronously */
+        if (!flush && et->update_sample_aspect_ratio)
+            enc->sample_aspect_ratio = frame->sample_aspect_ratio;
+
+        trace_start = trace_span_begin();
+        stage_timer_start(&timer);
+        ret = avcodec_send_frame(enc, flush ? NULL : frame);
+        stage_timer_stop(&timer, et->encode_time);
+        trace_span_end("encode", trace_start);
+        av_frame_unref(frame);
+        if (ret < 0 && !(ret == AVERROR_EOF && flush)) {
+            if ((ret = enc_thread_output(et, item, ret, 1)) < 0)
+                goto finish;
+            continue;
+        }
+
+        while (1) {
+            trace_start = trace_span_begin();
+            stage_timer_start(&timer);
+            ret = avcodec_receive_packet(enc, item->pkt);
+            stage_timer_stop(&timer, et->encode_time);
+            trace_span_end("encode", trace_start);
+            if (ret == AVERROR(EAGAIN)) {
+                av_assert0(!flush); // should never happen during flushing
+                break;
+            }
+
+            item->pkt->time_base = enc->time_base;
+
+            if ((ret = enc_thread_output(et, item, ret, 0)) < 0)
+                goto finish;
+            if (item->ret < 0)
+                break;
+        }
+    }
+
+finish:
+    if (ret < 0 && ret != AVERROR_EOF)
+        av_log(enc, AV_LOG_ERROR, "Encoder thread terminated: %s\n", av_err2str(ret));
+
+    pthread_mutex_lock(&et->lock);
+    et->error = ret < 0 && ret != AVERROR_EOF ? ret : AVERROR_EXIT;
+    atomic_store(&et->finished, 1);
+    pthread_cond_signal(&et->cond);
+    pthread_mutex_unlock(&et->lock);
+
+    tq_send_finish(et->queue_out, 0);
+
+    av_frame_free(&frame);
+    enc_item_free((void**)&item);
+
+    trace_thread_uninit();
+
+    return NULL;
+}
+
+static int enc_thread_supported(OutputStream *ost)
+{
+    if (!threaded_encoding || !ost->enc_ctx)
+        return 0;
+
+    if (ost->enc_ctx->codec_type != AVMEDIA_TYPE_VIDEO &&
+        ost->enc_ctx->codec_type != AVMEDIA_TYPE_AUDIO)
+        return 0;
+
+    /* two pass statistics are read from the encoder after every packet */
+    if (ost->logfile)
+        return 0;
+
+    return 1;
+}
+
+static int enc_thread_start(OutputStream *ost)
+{
+    EncoderThread *et;
+    ObjPool *op;
+    int ret;
+
+    et = av_mallocz(sizeof(*et));
+    if (!et)
+        return AVERROR(ENOMEM);
+    ost->enc_thread = et;
+
+    et->session_id                 = globalSessionId;
+    et->update_sample_aspect_ratio = ost->enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO &&
+                                     !ost->frame_aspect_ratio.num;
+    et->enc_ctx                    = ost->enc_ctx;
+    et->encode_time                = &ost->encode_time;
+    et->tracer                     = trace_session();
+    et->file_index                 = ost->file_index;
+    et->index                      = ost->index;
+    atomic_init(&et->frames_taken, 0);
+    atomic_init(&et->items_sent,   0);
+    atomic_init(&et->finished,     0);
+
+    if ((ret = pthread_mutex_init(&et->lock, NULL)))
+        return AVERROR(ret);
+    if ((ret = pthread_cond_init(&et->cond, NULL))) {
+        pthread_mutex_destroy(&et->lock);
+        return AVERROR(ret);
+    }
+    et->lock_initialized = 1;
+
+    et->frame = av_frame_alloc();
+    et->item  = enc_item_alloc();
+    if (!et->frame || !et->item)
+        return AVERROR(ENOMEM);
+
+    /* one extra slot for the flush request */
+    op = objpool_session_frames();
+    if (!op)
+        return AVERROR(ENOMEM);
+    et->queue_in = tq_alloc(2, ENC_THREAD_QUEUE_SIZE + 1, op, enc_frame_move);
+    if (!et->queue_in) {
+        objpool_free(&op);
+        return AVERROR(ENOMEM);
+    }
+
+    op = objpool_alloc(enc_item_alloc, enc_item_reset, enc_item_free);
+    if (!op)
+        return AVERROR(ENOMEM);
+    et->queue_out = tq_alloc(1, ENC_THREAD_QUEUE_SIZE, op, enc_item_move);
+    if (!et->queue_out) {
+        objpool_free(&op);
+        return AVERROR(ENOMEM);
+    }
+
+    if ((ret = pthread_create(&et->thread, NULL, enc_thread_main, et))) {
+        av_log(ost, AV_LOG_ERROR, "pthread_create failed: %s. Try to increase `ulimit -v` or decrease `ulimit -s`.\n", strerror(ret));
+        return AVERROR(ret);
+    }
+    et->thread_started = 1;
+
+    return 0;
+}
+
+void enc_thread_stop(OutputStream *ost)
+{
+    EncoderThread *et = ost->enc_thread;
+
+    if (!et)
+        return;
+
+    if (et->queue_in) {
+        tq_send_finish(et->queue_in, 0);
+        tq_send_finish(et->queue_in, 1);
+    }
+    if (et->queue_out)
+        tq_receive_finish(et->queue_out, 0);
+
+    if (et->thread_started)
+        pthread_join(et->thread, NULL);
+
+    tq_free(&et->queue_in);
+    tq_free(&et->queue_out);
+
+    if (et->lock_initialized) {
+        pthread_cond_destroy(&et->cond);
+        pthread_mutex_destroy(&et->lock);
+    }
+
+    av_frame_free(&et->frame);
+    enc_item_free((void**)&et->item);
+
+    av_freep(&ost->enc_thread);
+}
+
+static void output_encoded_packet(OutputFile *of, OutputStream *ost, AVPacket *pkt);
+
+/* receive and output the next EncoderItem, blocks until there is one */
+static int enc_thread_receive(OutputFile *of, OutputStream *ost)
+{
+    EncoderThread *et = ost->enc_thread;
+    EncoderItem *item = et->item;
+    const char *type_desc = av_get_media_type_string(ost->enc_ctx->codec_type);
+    int stream_idx, ret;
+
+    ret = tq_receive(et->queue_out, &stream_idx, item);
+    if (ret < 0)
+        return et->error;
+    et->items_received++;
+
+    if (item->ret >= 0) {
+        output_encoded_packet(of, ost, item->pkt);
+        return 0;
+    }
+
+    if (item->ret == AVERROR_EOF) {
+        of_output_packet(of, item->pkt, ost, 1);
+    } else if (item->submit) {
+        av_log(ost, AV_LOG_ERROR, "Error submitting %s frame to the encoder\n",
+               type_desc);
+    } else {
+        av_log(ost, AV_LOG_ERROR, "%s encoding failed\n", type_desc);
+    }
+
+    return item->ret;
+}
+
+/* output the packets the encoder thread has returned so far, without waiting */
+static int enc_thread_drain(OutputFile *of, OutputStream *ost)
+{
+    EncoderThread *et = ost->enc_thread;
+    int ret;
+
+    while (atomic_load(&et->items_sent) > et->items_received) {
+        ret = enc_thread_receive(of, ost);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+/*
+ * Wait until the encoder thread has taken enough frames for the next one to
+ * fit in its queue. Packets returned meanwhile are output, so that the encoder
+ * thread never blocks on a full output queue while the transcode thread waits.
+ */
+static int enc_thread_wait(OutputFile *of, OutputStream *ost)
+{
+    EncoderThread *et = ost->enc_thread;
+    int ret;
+
+    while (et->frames_sent - atomic_load(&et->frames_taken) >= ENC_THREAD_QUEUE_SIZE) {
+        if (atomic_load(&et->items_sent) > et->items_received) {
+            if ((ret = enc_thread_receive(of, ost)) < 0)
+                return ret;
+            continue;
+        }
+
+        pthread_mutex_lock(&et->lock);
+        while (et->frames_sent - atomic_load(&et->frames_taken) >= ENC_THREAD_QUEUE_SIZE &&
+               atomic_load(&et->items_sent) == et->items_received &&
+               !atomic_load(&et->finished))
+            pthread_cond_wait(&et->cond, &et->lock);
+        ret = atomic_load(&et->finished) ? et->error : 0;
+        pthread_mutex_unlock(&et->lock);
+
+        if (ret < 0 && atomic_load(&et->items_sent) == et->items_received)
+            return ret;
+    }
+
+    return 0;
+}
+
+/*
+ * Queue a frame to the encoder thread of the output stream and output the
+ * packets that are ready. frame = NULL flushes the encoder and waits for all
+ * of its packets, the same way encode_frame() does when encoding
+ * synchronously.
+ */
+static int enc_thread_send_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
+{
+    EncoderThread *et = ost->enc_thread;
+    int ret;
+
+    if ((ret = enc_thread_wait(of, ost)) < 0)
+        return ret;
+
+    if (frame) {
+        ret = av_frame_ref(et->frame, frame);
+        if (ret < 0)
+            return ret;
+    }
+
+    ret = tq_send(et->queue_in, frame ? 0 : 1, et->frame);
+    if (ret < 0) {
+        av_frame_unref(et->frame);
+        return ret;
+    }
+    et->frames_sent++;
+
+    if (frame)
+        return enc_thread_drain(of, ost);
+
+    while ((ret = enc_thread_receive(of, ost)) >= 0);
+
+    return ret;
+}
+
+static int do_encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
 {
     AVCodecContext   *enc = ost->enc_ctx;
     AVPacket         *pkt = ost->pkt;
     const char *type_desc = av_get_media_type_string(enc->codec_type);
     const char    *action = frame ? "encode" : "flush";
+    StageTimer timer;
+    int64_t trace_start;
     int ret;
 
     if (frame) {
@@ -1062,9 +1600,16 @@ static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
         }
     }
 
+    if (ost->enc_thread)
+        return enc_thread_send_frame(of, ost, frame);
+
     update_benchmark(NULL);
 
+    trace_start = trace_span_begin();
+    stage_timer_start(&timer);
     ret = avcodec_send_frame(enc, frame);
+    stage_timer_stop(&timer, &ost->encode_time);
+    trace_span_end("encode", trace_start);
     if (ret < 0 && !(ret == AVERROR_EOF && !frame)) {
         av_log(ost, AV_LOG_ERROR, "Error submitting %s frame to the encoder\n",
                type_desc);
@@ -1072,7 +1617,11 @@ static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
     }
 
     while (1) {
+        trace_start = trace_span_begin();
+        stage_timer_start(&timer);
         ret = avcodec_receive_packet(enc, pkt);
+        stage_timer_stop(&timer, &ost->encode_time);
+        trace_span_end("encode", trace_start);
         update_benchmark("%s_%s %d.%d", action, type_desc,
                          ost->file_index, ost->index);
 
@@ -1093,50 +1642,70 @@ static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
             return ret;
         }
 
-        if (enc->codec_type == AVMEDIA_TYPE_VIDEO)
-            update_video_stats(ost, pkt, !!vstats_filename);
-        if (ost->enc_stats_post.io)
-            enc_stats_write(ost, &ost->enc_stats_post, NULL, pkt,
-                            ost->packets_encoded);
+        output_encoded_packet(of, ost, pkt);
+    }
 
-        if (debug_ts) {
-            av_log(ost, AV_LOG_INFO, "encoder -> type:%s "
-                   "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s "
-                   "duration:%s duration_time:%s\n",
-                   type_desc,
-                   av_ts2str(pkt->pts), av_ts2timestr(pkt->pts, &enc->time_base),
-                   av_ts2str(pkt->dts), av_ts2timestr(pkt->dts, &enc->time_base),
-                   av_ts2str(pkt->duration), av_ts2timestr(pkt->duration, &enc->time_base));
-        }
+    av_assert0(0);
+}
 
-        av_packet_rescale_ts(pkt, pkt->time_base, ost->mux_timebase);
-        pkt->time_base = ost->mux_timebase;
+static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
+{
+    int64_t trace_start = trace_span_begin();
+    int ret;
 
-        if (debug_ts) {
-            av_log(ost, AV_LOG_INFO, "encoder -> type:%s "
-                   "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s "
-                   "duration:%s duration_time:%s\n",
-                   type_desc,
-                   av_ts2str(pkt->pts), av_ts2timestr(pkt->pts, &enc->time_base),
-                   av_ts2str(pkt->dts), av_ts2timestr(pkt->dts, &enc->time_base),
-                   av_ts2str(pkt->duration), av_ts2timestr(pkt->duration, &enc->time_base));
-        }
+    ret = do_encode_frame(of, ost, frame);
+    trace_span_end("encode_frame", trace_start);
 
-        if ((ret = trigger_fix_sub_duration_heartbeat(ost, pkt)) < 0) {
-            av_log(NULL, AV_LOG_ERROR,
-                   "Subtitle heartbeat logic failed in %s! (%s)\n",
-                   __func__, av_err2str(ret));
-            exit_program(1);
-        }
+    return ret;
+}
 
-        ost->data_size_enc += pkt->size;
+static void output_encoded_packet(OutputFile *of, OutputStream *ost, AVPacket *pkt)
+{
+    AVCodecContext   *enc = ost->enc_ctx;
+    const char *type_desc = av_get_media_type_string(enc->codec_type);
+    int ret;
 
-        ost->packets_encoded++;
+    if (enc->codec_type == AVMEDIA_TYPE_VIDEO)
+        update_video_stats(ost, pkt, !!vstats_filename);
+    if (ost->enc_stats_post.io)
+        enc_stats_write(ost, &ost->enc_stats_post, NULL, pkt,
+                        ost->packets_encoded);
 
-        of_output_packet(of, pkt, ost, 0);
+    if (debug_ts) {
+        av_log(ost, AV_LOG_INFO, "encoder -> type:%s "
+               "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s "
+               "duration:%s duration_time:%s\n",
+               type_desc,
+               av_ts2str(pkt->pts), av_ts2timestr(pkt->pts, &enc->time_base),
+               av_ts2str(pkt->dts), av_ts2timestr(pkt->dts, &enc->time_base),
+               av_ts2str(pkt->duration), av_ts2timestr(pkt->duration, &enc->time_base));
     }
 
-    av_assert0(0);
+    av_packet_rescale_ts(pkt, pkt->time_base, ost->mux_timebase);
+    pkt->time_base = ost->mux_timebase;
+
+    if (debug_ts) {
+        av_log(ost, AV_LOG_INFO, "encoder -> type:%s "
+               "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s "
+               "duration:%s duration_time:%s\n",
+               type_desc,
+               av_ts2str(pkt->pts), av_ts2timestr(pkt->pts, &enc->time_base),
+               av_ts2str(pkt->dts), av_ts2timestr(pkt->dts, &enc->time_base),
+               av_ts2str(pkt->duration), av_ts2timestr(pkt->duration, &enc->time_base));
+    }
+
+    if ((ret = trigger_fix_sub_duration_heartbeat(ost, pkt)) < 0) {
+        av_log(NULL, AV_LOG_ERROR,
+               "Subtitle heartbeat logic failed in %s! (%s)\n",
+               __func__, av_err2str(ret));
+        exit_program(1);
+    }
+
+    ost->data_size_enc += pkt->size;
+
+    ost->packets_encoded++;
+
+    of_output_packet(of, pkt, ost, 0);
 }
 
 static int submit_encode_frame(OutputFile *of, OutputStream *ost,
@@ -1219,6 +1788,8 @@ static void do_subtitle_out(OutputFile *of,
     int subtitle_out_size, nb, i, ret;
     AVCodecContext *enc;
     AVPacket *pkt = ost->pkt;
+    StageTimer timer;
+    int64_t trace_start;
     int64_t pts;
 
     if (sub->pts == AV_NOPTS_VALUE) {
@@ -1262,7 +1833,11 @@ static void do_subtitle_out(OutputFile *of,
 
         ost->frames_encoded++;
 
+        trace_start = trace_span_begin();
+        stage_timer_start(&timer);
         subtitle_out_size = avcodec_encode_subtitle(enc, pkt->data, pkt->size, sub);
+        stage_timer_stop(&timer, &ost->encode_time);
+        trace_span_end("encode", trace_start);
         if (i == 1)
             sub->num_rects = save_num_rects;
         if (subtitle_out_size < 0) {
@@ -1460,6 +2035,7 @@ static void do_video_out(OutputFile *of,
 
     if (nb_frames_prev == 0 && ost->last_dropped) {
         nb_frames_drop++;
+        ost->nb_frames_drop++;
         av_log(ost, AV_LOG_VERBOSE,
                "*** dropping frame %"PRId64" at ts %"PRId64"\n",
                ost->vsync_frame_number, ost->last_frame->pts);
@@ -1468,9 +2044,11 @@ static void do_video_out(OutputFile *of,
         if (nb_frames > dts_error_threshold * 30) {
             av_log(ost, AV_LOG_ERROR, "%"PRId64" frame duplication too large, skipping\n", nb_frames - 1);
             nb_frames_drop++;
+            ost->nb_frames_drop++;
             return;
         }
         nb_frames_dup += nb_frames - (nb_frames_prev && ost->last_dropped) - (nb_frames > nb_frames_prev);
+        ost->nb_frames_dup += nb_frames - (nb_frames_prev && ost->last_dropped) - (nb_frames > nb_frames_prev);
         av_log(ost, AV_LOG_VERBOSE, "*** %"PRId64" dup!\n", nb_frames - 1);
         if (nb_frames_dup > dup_warning) {
             av_log(ost, AV_LOG_WARNING, "More than %"PRIu64" frames duplicated\n", dup_warning);
@@ -1524,6 +2102,8 @@ static void do_video_out(OutputFile *of,
 static int reap_filters(int flush)
 {
     AVFrame *filtered_frame = NULL;
+    StageTimer timer;
+    int64_t trace_start = trace_span_begin();
 
     /* Reap all buffers present in the buffer sinks */
     for (OutputStream *ost = ost_iter(NULL); ost; ost = ost_iter(ost)) {
@@ -1536,6 +2116,13 @@ static int reap_filters(int flush)
             continue;
         filter = ost->filter->filter;
 
+        ret = fg_thread_wait(ost->filter->graph);
+        if (ret < 0) {
+            av_log(NULL, AV_LOG_ERROR, "Error while filtering: %s\n", av_err2str(ret));
+            trace_span_end("reap_filters", trace_start);
+            return ret;
+        }
+
         /*
          * Unlike video, with audio the audio frame size matters.
          * Currently we are fully reliant on the lavfi filter chain to
@@ -1551,8 +2138,13 @@ static int reap_filters(int flush)
         filtered_frame = ost->filtered_frame;
 
         while (1) {
+            int64_t sink_start = trace_span_begin();
+
+            stage_timer_start(&timer);
             ret = av_buffersink_get_frame_flags(filter, filtered_frame,
                                                AV_BUFFERSINK_FLAG_NO_REQUEST);
+            stage_timer_stop(&timer, &ost->filter_time);
+            trace_span_end("buffersink", sink_start);
             if (ret < 0) {
                 if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
                     av_log(NULL, AV_LOG_WARNING,
@@ -1567,11 +2159,13 @@ static int reap_filters(int flush)
                 av_frame_unref(filtered_frame);
                 continue;
             }
+            ost->frames_filtered++;
 
             if (filtered_frame->pts != AV_NOPTS_VALUE) {
                 AVRational tb = av_buffersink_get_time_base(filter);
                 ost->last_filter_pts = av_rescale_q(filtered_frame->pts, tb,
                                                     AV_TIME_BASE_Q);
+                ost_heap_update(ost);
                 filtered_frame->time_base = tb;
 
                 if (debug_ts)
@@ -1583,7 +2177,8 @@ static int reap_filters(int flush)
 
             switch (av_buffersink_get_type(filter)) {
             case AVMEDIA_TYPE_VIDEO:
-                if (!ost->frame_aspect_ratio.num)
+                /* encoder threads update it themselves, see enc_thread_main() */
+                if (!ost->frame_aspect_ratio.num && !ost->enc_thread)
                     enc->sample_aspect_ratio = filtered_frame->sample_aspect_ratio;
 
                 do_video_out(of, ost, filtered_frame);
@@ -1604,8 +2199,14 @@ static int reap_filters(int flush)
 
             av_frame_unref(filtered_frame);
         }
+
+        /* output what the encoder thread has finished meanwhile */
+        if (ost->enc_thread && enc_thread_drain(of, ost) < 0)
+            exit_program(1);
     }
 
+    trace_span_end("reap_filters", trace_start);
+
     return 0;
 }
 
@@ -1745,6 +2346,95 @@ static void forward_report(uint64_t frame_number, float fps, float quality, int6
     }
 }
 
+static int64_t thread_cpu_time(void)
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts;
+
+    if (!clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+        return ts.tv_sec * INT64_C(1000000) + ts.tv_nsec / 1000;
+#endif
+    return 0;
+}
+
+void stage_timer_start(StageTimer *timer)
+{
+    if (!atomic_load_explicit(&stage_timing, memory_order_relaxed)) {
+        timer->wall = -1;
+        return;
+    }
+
+    timer->wall = av_gettime_relative();
+    timer->cpu  = thread_cpu_time();
+}
+
+void stage_timer_stop(const StageTimer *timer, StageTime *time)
+{
+    if (timer->wall < 0)
+        return;
+
+    atomic_fetch_add_explicit(&time->wall, av_gettime_relative() - timer->wall, memory_order_relaxed);
+    atomic_fetch_add_explicit(&time->cpu,  thread_cpu_time()     - timer->cpu,  memory_order_relaxed);
+}
+
+static void stage_time_report(const StageTime *time, int64_t *wall, int64_t *cpu)
+{
+    *wall = atomic_load_explicit(&time->wall, memory_order_relaxed);
+    *cpu  = atomic_load_explicit(&time->cpu,  memory_order_relaxed);
+}
+
+static void forward_stream_report(void)
+{
+    void (*callback)(const StreamReport *, int) = stream_report_callback;
+    StreamReport *reports, *r;
+    int nb_reports = 0;
+
+    if (!callback)
+        return;
+
+    for (InputStream *ist = ist_iter(NULL); ist; ist = ist_iter(ist))
+        nb_reports++;
+    for (OutputStream *ost = ost_iter(NULL); ost; ost = ost_iter(ost))
+        nb_reports++;
+
+    reports = av_calloc(FFMAX(nb_reports, 1), sizeof(*reports));
+    if (!reports)
+        return;
+
+    r = reports;
+    for (InputStream *ist = ist_iter(NULL); ist; ist = ist_iter(ist), r++) {
+        r->file_index      = ist->file_index;
+        r->index           = ist->st->index;
+        r->type            = ist->par->codec_type;
+        r->packets_demuxed = ist->nb_packets;
+        r->frames_decoded  = ist->frames_decoded;
+        r->frames_filtered = ist->frames_filtered;
+        r->queue_depth     = ifile_queue_depth(input_files[ist->file_index]);
+        stage_time_report(&ist->decode_time, &r->decode_wall_time, &r->decode_cpu_time);
+        stage_time_report(&ist->filter_time, &r->filter_wall_time, &r->filter_cpu_time);
+    }
+    for (OutputStream *ost = ost_iter(NULL); ost; ost = ost_iter(ost), r++) {
+        r->file_index      = ost->file_index;
+        r->index           = ost->index;
+        r->output          = 1;
+        r->type            = ost->st->codecpar->codec_type;
+        r->frames_filtered = ost->frames_filtered;
+        r->frames_encoded  = ost->frames_encoded;
+        r->packets_encoded = ost->packets_encoded;
+        r->packets_muxed   = atomic_load(&ost->packets_written);
+        r->frames_dup      = ost->nb_frames_dup;
+        r->frames_drop     = ost->nb_frames_drop;
+        r->queue_depth     = of_queue_depth(output_files[ost->file_index]);
+        stage_time_report(&ost->filter_time, &r->filter_wall_time, &r->filter_cpu_time);
+        stage_time_report(&ost->encode_time, &r->encode_wall_time, &r->encode_cpu_time);
+        stage_time_report(&ost->mux_time,    &r->mux_wall_time,    &r->mux_cpu_time);
+    }
+
+    callback(reports, nb_reports);
+
+    av_free(reports);
+}
+
 static void print_report(int is_last_report, int64_t timer_start, int64_t cur_time)
 {
     AVBPrint buf, buf_script;
@@ -1862,8 +2552,10 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
             }
         }
 
-        if (is_last_report)
+        if (is_last_report) {
             nb_frames_drop += ost->last_dropped;
+            ost->nb_frames_drop += ost->last_dropped;
+        }
     }
 
     us    = FFABS64U(pts) % AV_TIME_BASE;
@@ -1875,7 +2567,8 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
     bitrate = pts != AV_NOPTS_VALUE && pts && total_size >= 0 ? total_size * 8 / (pts / 1000.0) : -1;
     speed   = pts != AV_NOPTS_VALUE && t != 0.0 ? (double)pts / AV_TIME_BASE / t : -1;
 
-    // FFmpegKit forward report
+    // FFmpegKit forward report, stream reports first so they are delivered with the statistics
+    forward_stream_report();
     forward_report(frame_number, fps, q, total_size, pts, bitrate, speed);
 
     if (local_print_stats) {
@@ -2167,12 +2860,20 @@ static int ifilter_send_frame(InputFilter *ifilter, AVFrame *frame, int keep_ref
 {
     FilterGraph *fg = ifilter->graph;
     AVFrameSideData *sd;
+    StageTimer timer;
+    int64_t trace_start;
     int need_reinit, ret;
     int buffersrc_flags = AV_BUFFERSRC_FLAG_PUSH;
 
     if (keep_reference)
         buffersrc_flags |= AV_BUFFERSRC_FLAG_KEEP_REF;
 
+    ret = fg_thread_wait(fg);
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Error while filtering: %s\n", av_err2str(ret));
+        return ret;
+    }
+
     /* determine if the parameters for this input changed */
     need_reinit = ifilter->format != frame->format;
 
@@ -2190,87 +2891,482 @@ static int ifilter_send_frame(InputFilter *ifilter, AVFrame *frame, int keep_ref
     if (!ifilter->ist->reinit_filters && fg->graph)
         need_reinit = 0;
 
-    if (!!ifilter->hw_frames_ctx != !!frame->hw_frames_ctx ||
-        (ifilter->hw_frames_ctx && ifilter->hw_frames_ctx->data != frame->hw_frames_ctx->data))
-        need_reinit = 1;
+    if (!!ifilter->hw_frames_ctx != !!frame->hw_frames_ctx ||
+        (ifilter->hw_frames_ctx && ifilter->hw_frames_ctx->data != frame->hw_frames_ctx->data))
+        need_reinit = 1;
+
+    if ((sd = av_frame_get_side_data(frame, AV_FRAME_DATA_DISPLAYMATRIX))) {
+        if (!ifilter->displaymatrix || memcmp(sd->data, ifilter->displaymatrix, sizeof(int32_t) * 9))
+            need_reinit = 1;
+    } else if (ifilter->displaymatrix)
+        need_reinit = 1;
+
+    if (need_reinit) {
+        ret = ifilter_parameters_from_frame(ifilter, frame);
+        if (ret < 0)
+            return ret;
+    }
+
+    /* (re)init the graph if possible, otherwise buffer the frame and return */
+    if (need_reinit || !fg->graph) {
+        if (!ifilter_has_all_input_formats(fg)) {
+            AVFrame *tmp = av_frame_clone(frame);
+            if (!tmp)
+                return AVERROR(ENOMEM);
+
+            ret = av_fifo_write(ifilter->frame_queue, &tmp, 1);
+            if (ret < 0)
+                av_frame_free(&tmp);
+
+            return ret;
+        }
+
+        ret = reap_filters(1);
+        if (ret < 0 && ret != AVERROR_EOF) {
+            av_log(NULL, AV_LOG_ERROR, "Error while filtering: %s\n", av_err2str(ret));
+            return ret;
+        }
+
+        ret = configure_filtergraph(fg);
+        if (ret < 0) {
+            av_log(NULL, AV_LOG_ERROR, "Error reinitializing filters!\n");
+            return ret;
+        }
+    }
+
+    if (fg->thread)
+        return fg_thread_send_frame(ifilter, frame, keep_reference);
+
+    trace_start = trace_span_begin();
+    stage_timer_start(&timer);
+    ret = av_buffersrc_add_frame_flags(ifilter->filter, frame, buffersrc_flags);
+    if (ifilter->ist)
+        stage_timer_stop(&timer, &ifilter->ist->filter_time);
+    trace_span_end("filter", trace_start);
+    if (ret < 0) {
+        if (ret != AVERROR_EOF)
+            av_log(NULL, AV_LOG_ERROR, "Error while filtering: %s\n", av_err2str(ret));
+        return ret;
+    }
+
+    return 0;
+}
+
+static int ifilter_send_eof(InputFilter *ifilter, int64_t pts)
+{
+    int ret = 0;
+
+    ifilter->eof = 1;
+
+    if (ifilter->filter) {
+        ret = fg_thread_wait(ifilter->graph);
+        if (ret < 0)
+            return ret;
+
+        /* THIS VALIDATION IS REQUIRED TO COMPLETE CANCELLATION */
+        if (!received_sigterm && !cancelRequested(globalSessionId)) {
+            ret = av_buffersrc_close(ifilter->filter, pts, AV_BUFFERSRC_FLAG_PUSH);
+        }
+        if (ret < 0)
+            return ret;
+    } else {
+        // the filtergraph was never configured
+        if (ifilter->format < 0) {
+            ret = ifilter_parameters_from_codecpar(ifilter, ifilter->ist->par);
+            if (ret < 0)
+                return ret;
+        }
+        if (ifilter->format < 0 && (ifilter->type == AVMEDIA_TYPE_AUDIO || ifilter->type == AVMEDIA_TYPE_VIDEO)) {
+            av_log(NULL, AV_LOG_ERROR, "Cannot determine format of input stream %d:%d after EOF\n", ifilter->ist->file_index, ifilter->ist->st->index);
+            return AVERROR_INVALIDDATA;
+        }
+    }
+
+    return 0;
+}
+
+/* number of packets the transcode thread may have queued for a decoder thread */
+#define DEC_THREAD_QUEUE_SIZE 8
+
+/* decoder context fields the transcode loop reads after decoding */
+typedef struct DecoderParams {
+    int        has_b_frames;
+    int        width;
+    int        height;
+    int        pix_fmt;
+    int        sample_rate;
+    AVRational framerate;
+    int        ticks_per_frame;
+} DecoderParams;
+
+/*
+ * Result of a single avcodec_receive_frame() call on a decoder thread. ret is
+ * 0 when frame holds a decoded frame, AVERROR(EAGAIN) when the decoder
+ * consumed the packet, AVERROR_EOF when it was fully drained or an error code.
+ */
+typedef struct DecoderItem {
+    AVFrame      *frame;
+    int           ret;
+    DecoderParams params;
+} DecoderItem;
+
+typedef struct DecoderPending {
+    AVPacket *pkt;
+    /* zero sized video packets are skipped by decode_video() and never sent */
+    int       sent;
+} DecoderPending;
+
+struct DecoderThread {
+    pthread_t       thread;
+    int             thread_started;
+
+    /* copied from the transcode thread, the decoder thread can not read thread-local options */
+    long            session_id;
+    int             want_frame_data;
+    AVCodecContext *dec_ctx;
+    StageTime      *decode_time;
+    Tracer         *tracer;
+    int             file_index;
+    int             index;
+
+    /* packets for the decoder, stream 0 carries packets and stream 1 flush requests */
+    ThreadQueue    *queue_in;
+    /* DecoderItems from the decoder */
+    ThreadQueue    *queue_out;
+
+    /* number of packets whose DecoderItems were all sent by the decoder thread */
+    atomic_int      packets_decoded;
+
+    /* the fields below are used by the transcode thread only */
+    AVFifo         *pending;
+    int             packets_processed;
+    int             flush_pending;
+    AVPacket       *pkt;
+    DecoderItem    *item;
+    DecoderParams   params;
+    /* dts prediction of handle_input_packet() made when video packets are sent */
+    int             saw_first_ts;
+    int64_t         next_dts;
+};
+
+static void dec_params_from_context(const AVCodecContext *avctx, DecoderParams *params)
+{
+    params->has_b_frames    = avctx->has_b_frames;
+    params->width           = avctx->width;
+    params->height          = avctx->height;
+    params->pix_fmt         = avctx->pix_fmt;
+    params->sample_rate     = avctx->sample_rate;
+    params->framerate       = avctx->framerate;
+    params->ticks_per_frame = avctx->ticks_per_frame;
+}
+
+/* decoder context fields as seen by the transcode thread */
+static void dec_get_params(const InputStream *ist, DecoderParams *params)
+{
+    if (ist->dec_thread)
+        *params = ist->dec_thread->params;
+    else
+        dec_params_from_context(ist->dec_ctx, params);
+}
+
+static int dec_frame_data_attach(AVCodecContext *avctx, AVFrame *frame)
+{
+    FrameData *fd;
+
+    av_assert0(!frame->opaque_ref);
+    frame->opaque_ref = av_buffer_allocz(sizeof(*fd));
+    if (!frame->opaque_ref) {
+        av_frame_unref(frame);
+        return AVERROR(ENOMEM);
+    }
+    fd      = (FrameData*)frame->opaque_ref->data;
+    fd->pts = frame->pts;
+    fd->tb  = avctx->pkt_timebase;
+    fd->idx = avctx->frame_num - 1;
+
+    return 0;
+}
+
+static void *dec_item_alloc(void)
+{
+    DecoderItem *item = av_mallocz(sizeof(*item));
+
+    if (!item)
+        return NULL;
+
+    item->frame = av_frame_alloc();
+    if (!item->frame)
+        av_freep(&item);
+
+    return item;
+}
+
+static void dec_item_reset(void *obj)
+{
+    DecoderItem *item = obj;
+
+    av_frame_unref(item->frame);
+    item->ret = 0;
+}
+
+static void dec_item_free(void **obj)
+{
+    DecoderItem *item = *obj;
+
+    if (item)
+        av_frame_free(&item->frame);
+    av_freep(obj);
+}
+
+static void dec_item_move(void *dst, void *src)
+{
+    DecoderItem *dst_item = dst;
+    DecoderItem *src_item = src;
+
+    av_frame_move_ref(dst_item->frame, src_item->frame);
+    dst_item->ret    = src_item->ret;
+    dst_item->params = src_item->params;
+}
+
+static void dec_pkt_move(void *dst, void *src)
+{
+    av_packet_move_ref(dst, src);
+}
+
+static int dec_thread_output(DecoderThread *dt, DecoderItem *item, int ret)
+{
+    item->ret = ret;
+    dec_params_from_context(dt->dec_ctx, &item->params);
+
+    ret = tq_send(dt->queue_out, 0, item);
+    if (ret < 0)
+        dec_item_reset(item);
+
+    return ret;
+}
+
+/*
+ * Decoder thread. Every packet is followed by the frames the decoder returns
+ * for it and a final item with AVERROR(EAGAIN), the same sequence decode()
+ * produces when it is called repeatedly on the transcode thread. A flush
+ * request drains the decoder until AVERROR_EOF and resets it, so that looped
+ * inputs can be decoded again.
+ */
+static void *dec_thread_main(void *arg)
+{
+    DecoderThread *dt = arg;
+    AVPacket *pkt = NULL;
+    DecoderItem *item = NULL;
+    StageTimer timer;
+    int64_t trace_start;
+    int ret = 0;
+
+    globalSessionId = dt->session_id;
+    trace_thread_init(dt->tracer, "decode %d:%d", dt->file_index, dt->index);
+
+    pkt  = av_packet_alloc();
+    item = dec_item_alloc();
+    if (!pkt || !item) {
+        ret = AVERROR(ENOMEM);
+        goto finish;
+    }
+
+    while (1) {
+        int stream_idx, flush, err;
+
+        ret = tq_receive(dt->queue_in, &stream_idx, pkt);
+        if (ret == AVERROR_EOF && stream_idx >= 0)
+            continue;
+        if (ret < 0)
+            break;
+
+        flush = stream_idx == 1;
+
+        trace_start = trace_span_begin();
+        stage_timer_start(&timer);
+        ret = avcodec_send_packet(dt->dec_ctx, flush ? NULL : pkt);
+        stage_timer_stop(&timer, dt->decode_time);
+        trace_span_end("decode", trace_start);
+        av_packet_unref(pkt);
+        if (ret < 0 && ret != AVERROR_EOF) {
+            if ((ret = dec_thread_output(dt, item, ret)) < 0)
+                goto finish;
+            if (!flush) {
+                atomic_fetch_add(&dt->packets_decoded, 1);
+                continue;
+            }
+        }
+
+        while (1) {
+            trace_start = trace_span_begin();
+            stage_timer_start(&timer);
+            ret = avcodec_receive_frame(dt->dec_ctx, item->frame);
+            stage_timer_stop(&timer, dt->decode_time);
+            trace_span_end("decode", trace_start);
+            if (ret >= 0 && dt->want_frame_data)
+                ret = dec_frame_data_attach(dt->dec_ctx, item->frame);
+            if (flush && ret == AVERROR(EAGAIN))
+                ret = AVERROR_EOF;
+
+            if ((err = dec_thread_output(dt, item, ret)) < 0) {
+                ret = err;
+                goto finish;
+            }
+
+            /* errors end a packet, while draining they are reported and draining goes on */
+            if (ret == AVERROR_EOF || (ret < 0 && !flush))
+                break;
+        }
+
+        if (flush)
+            avcodec_flush_buffers(dt->dec_ctx);
+        else
+            atomic_fetch_add(&dt->packets_decoded, 1);
+    }
+
+finish:
+    if (ret < 0 && ret != AVERROR_EOF)
+        av_log(dt->dec_ctx, AV_LOG_ERROR, "Decoder thread terminated: %s\n", av_err2str(ret));
+
+    /* unblocks the transcode thread if the decoder thread stops early */
+    tq_send_finish(dt->queue_out, 0);
+
+    av_packet_free(&pkt);
+    dec_item_free((void**)&item);
+
+    trace_thread_uninit();
+
+    return NULL;
+}
+
+static int dec_thread_supported(InputStream *ist)
+{
+    if (!threaded_decoding || !ist->decoding_needed)
+        return 0;
+
+    if (ist->par->codec_type != AVMEDIA_TYPE_VIDEO &&
+        ist->par->codec_type != AVMEDIA_TYPE_AUDIO)
+        return 0;
+
+    /* hwaccel setup in get_format() depends on the transcode thread state */
+    if (ist->hwaccel_id != HWACCEL_NONE || ist->dec_ctx->hw_device_ctx)
+        return 0;
+
+    /* stream copy reads the timestamps maintained by the decoding code */
+    for (OutputStream *ost = ost_iter(NULL); ost; ost = ost_iter(ost))
+        if (ost->ist == ist && !ost->enc_ctx)
+            return 0;
+
+    return 1;
+}
+
+static int dec_thread_start(InputStream *ist)
+{
+    DecoderThread *dt;
+    ObjPool *op;
+    int ret;
+
+    dt = av_mallocz(sizeof(*dt));
+    if (!dt)
+        return AVERROR(ENOMEM);
+    ist->dec_thread = dt;
+
+    dt->session_id      = globalSessionId;
+    dt->decode_time     = &ist->decode_time;
+    dt->tracer          = trace_session();
+    dt->file_index      = ist->file_index;
+    dt->index           = ist->st->index;
+    dt->want_frame_data = ist->want_frame_data;
+    dt->dec_ctx         = ist->dec_ctx;
+    atomic_init(&dt->packets_decoded, 0);
+    dec_params_from_context(ist->dec_ctx, &dt->params);
+    dt->next_dts        = AV_NOPTS_VALUE;
+
+    dt->pending = av_fifo_alloc2(DEC_THREAD_QUEUE_SIZE, sizeof(DecoderPending), AV_FIFO_FLAG_AUTO_GROW);
+    dt->pkt     = av_packet_alloc();
+    dt->item    = dec_item_alloc();
+    if (!dt->pending || !dt->pkt || !dt->item)
+        return AVERROR(ENOMEM);
 
-    if ((sd = av_frame_get_side_data(frame, AV_FRAME_DATA_DISPLAYMATRIX))) {
-        if (!ifilter->displaymatrix || memcmp(sd->data, ifilter->displaymatrix, sizeof(int32_t) * 9))
-            need_reinit = 1;
-    } else if (ifilter->displaymatrix)
-        need_reinit = 1;
+    /* one extra slot for the flush request */
+    op = objpool_session_packets();
+    if (!op)
+        return AVERROR(ENOMEM);
+    dt->queue_in = tq_alloc(2, DEC_THREAD_QUEUE_SIZE + 1, op, dec_pkt_move);
+    if (!dt->queue_in) {
+        objpool_free(&op);
+        return AVERROR(ENOMEM);
+    }
 
-    if (need_reinit) {
-        ret = ifilter_parameters_from_frame(ifilter, frame);
-        if (ret < 0)
-            return ret;
+    op = objpool_alloc(dec_item_alloc, dec_item_reset, dec_item_free);
+    if (!op)
+        return AVERROR(ENOMEM);
+    dt->queue_out = tq_alloc(1, DEC_THREAD_QUEUE_SIZE, op, dec_item_move);
+    if (!dt->queue_out) {
+        objpool_free(&op);
+        return AVERROR(ENOMEM);
     }
 
-    /* (re)init the graph if possible, otherwise buffer the frame and return */
-    if (need_reinit || !fg->graph) {
-        if (!ifilter_has_all_input_formats(fg)) {
-            AVFrame *tmp = av_frame_clone(frame);
-            if (!tmp)
-                return AVERROR(ENOMEM);
+    if ((ret = pthread_create(&dt->thread, NULL, dec_thread_main, dt))) {
+        av_log(NULL, AV_LOG_ERROR, "pthread_create failed: %s. Try to increase `ulimit -v` or decrease `ulimit -s`.\n", strerror(ret));
+        return AVERROR(ret);
+    }
+    dt->thread_started = 1;
 
-            ret = av_fifo_write(ifilter->frame_queue, &tmp, 1);
-            if (ret < 0)
-                av_frame_free(&tmp);
+    return 0;
+}
 
-            return ret;
-        }
+void dec_thread_stop(InputStream *ist)
+{
+    DecoderThread *dt = ist->dec_thread;
+    DecoderPending pending;
 
-        ret = reap_filters(1);
-        if (ret < 0 && ret != AVERROR_EOF) {
-            av_log(NULL, AV_LOG_ERROR, "Error while filtering: %s\n", av_err2str(ret));
-            return ret;
-        }
+    if (!dt)
+        return;
 
-        ret = configure_filtergraph(fg);
-        if (ret < 0) {
-            av_log(NULL, AV_LOG_ERROR, "Error reinitializing filters!\n");
-            return ret;
-        }
+    if (dt->queue_in) {
+        tq_send_finish(dt->queue_in, 0);
+        tq_send_finish(dt->queue_in, 1);
     }
+    if (dt->queue_out)
+        tq_receive_finish(dt->queue_out, 0);
 
-    ret = av_buffersrc_add_frame_flags(ifilter->filter, frame, buffersrc_flags);
-    if (ret < 0) {
-        if (ret != AVERROR_EOF)
-            av_log(NULL, AV_LOG_ERROR, "Error while filtering: %s\n", av_err2str(ret));
-        return ret;
+    if (dt->thread_started)
+        pthread_join(dt->thread, NULL);
+
+    tq_free(&dt->queue_in);
+    tq_free(&dt->queue_out);
+
+    if (dt->pending) {
+        while (av_fifo_read(dt->pending, &pending, 1) >= 0)
+            av_packet_free(&pending.pkt);
+        av_fifo_freep2(&dt->pending);
     }
+    av_packet_free(&dt->pkt);
+    dec_item_free((void**)&dt->item);
 
-    return 0;
+    av_freep(&ist->dec_thread);
 }
 
-static int ifilter_send_eof(InputFilter *ifilter, int64_t pts)
+/* takes the next DecoderItem, replaces the avcodec calls in decode() */
+static int dec_thread_receive(InputStream *ist, AVFrame *frame, int *got_frame)
 {
-    int ret = 0;
-
-    ifilter->eof = 1;
+    DecoderThread *dt = ist->dec_thread;
+    int stream_idx, ret;
 
-    if (ifilter->filter) {
+    ret = tq_receive(dt->queue_out, &stream_idx, dt->item);
+    if (ret < 0)
+        return AVERROR_EOF;
 
-        /* THIS VALIDATION IS REQUIRED TO COMPLETE CANCELLATION */
-        if (!received_sigterm && !cancelRequested(globalSessionId)) {
-            ret = av_buffersrc_close(ifilter->filter, pts, AV_BUFFERSRC_FLAG_PUSH);
-        }
-        if (ret < 0)
-            return ret;
-    } else {
-        // the filtergraph was never configured
-        if (ifilter->format < 0) {
-            ret = ifilter_parameters_from_codecpar(ifilter, ifilter->ist->par);
-            if (ret < 0)
-                return ret;
-        }
-        if (ifilter->format < 0 && (ifilter->type == AVMEDIA_TYPE_AUDIO || ifilter->type == AVMEDIA_TYPE_VIDEO)) {
-            av_log(NULL, AV_LOG_ERROR, "Cannot determine format of input stream %d:%d after EOF\n", ifilter->ist->file_index, ifilter->ist->st->index);
-            return AVERROR_INVALIDDATA;
-        }
+    dt->params = dt->item->params;
+    ret = dt->item->ret;
+    if (ret >= 0) {
+        av_frame_move_ref(frame, dt->item->frame);
+        *got_frame = 1;
+        return 0;
     }
 
-    return 0;
+    return ret == AVERROR(EAGAIN) ? 0 : ret;
 }
 
 // This does not quite work like avcodec_decode_audio4/avcodec_decode_video2.
@@ -2280,35 +3376,38 @@ static int ifilter_send_eof(InputFilter *ifilter, int64_t pts)
 static int decode(InputStream *ist, AVCodecContext *avctx,
                   AVFrame *frame, int *got_frame, AVPacket *pkt)
 {
+    StageTimer timer;
+    int64_t trace_start;
     int ret;
 
     *got_frame = 0;
 
+    if (ist->dec_thread)
+        return dec_thread_receive(ist, frame, got_frame);
+
+    trace_start = trace_span_begin();
+    stage_timer_start(&timer);
     if (pkt) {
         ret = avcodec_send_packet(avctx, pkt);
         // In particular, we don't expect AVERROR(EAGAIN), because we read all
         // decoded frames with avcodec_receive_frame() until done.
-        if (ret < 0 && ret != AVERROR_EOF)
+        if (ret < 0 && ret != AVERROR_EOF) {
+            stage_timer_stop(&timer, &ist->decode_time);
+            trace_span_end("decode", trace_start);
             return ret;
+        }
     }
 
     ret = avcodec_receive_frame(avctx, frame);
+    stage_timer_stop(&timer, &ist->decode_time);
+    trace_span_end("decode", trace_start);
     if (ret < 0 && ret != AVERROR(EAGAIN))
         return ret;
     if (ret >= 0) {
         if (ist->want_frame_data) {
-            FrameData *fd;
-
-            av_assert0(!frame->opaque_ref);
-            frame->opaque_ref = av_buffer_allocz(sizeof(*fd));
-            if (!frame->opaque_ref) {
-                av_frame_unref(frame);
-                return AVERROR(ENOMEM);
-            }
-            fd      = (FrameData*)frame->opaque_ref->data;
-            fd->pts = frame->pts;
-            fd->tb  = avctx->pkt_timebase;
-            fd->idx = avctx->frame_num - 1;
+            ret = dec_frame_data_attach(avctx, frame);
+            if (ret < 0)
+                return ret;
         }
 
         *got_frame = 1;
@@ -2322,6 +3421,7 @@ static int send_frame_to_filters(InputStream *ist, AVFrame *decoded_frame)
     int i, ret;
 
     av_assert1(ist->nb_filters > 0); /* ensure ret is initialized */
+    ist->frames_filtered++;
     for (i = 0; i < ist->nb_filters; i++) {
         ret = ifilter_send_frame(ist->filters[i], decoded_frame, i < ist->nb_filters - 1);
         if (ret == AVERROR_EOF)
@@ -2399,6 +3499,7 @@ static int decode_video(InputStream *ist, AVPacket *pkt, int *got_output, int64_
     int i, ret = 0, err = 0;
     int64_t best_effort_timestamp;
     int64_t dts = AV_NOPTS_VALUE;
+    DecoderParams params;
 
     // With fate-indeo3-2, we're getting 0-sized packets before EOF for some
     // reason. This seems like a semi-critical bug. Don't trigger EOF, and
@@ -2428,18 +3529,20 @@ static int decode_video(InputStream *ist, AVPacket *pkt, int *got_output, int64_
     if (ret < 0)
         *decode_failed = 1;
 
+    dec_get_params(ist, &params);
+
     // The following line may be required in some cases where there is no parser
     // or the parser does not has_b_frames correctly
-    if (ist->par->video_delay < ist->dec_ctx->has_b_frames) {
+    if (ist->par->video_delay < params.has_b_frames) {
         if (ist->dec_ctx->codec_id == AV_CODEC_ID_H264) {
-            ist->par->video_delay = ist->dec_ctx->has_b_frames;
+            ist->par->video_delay = params.has_b_frames;
         } else
             av_log(ist->dec_ctx, AV_LOG_WARNING,
                    "video_delay is larger in decoder than demuxer %d > %d.\n"
                    "If you want to help, upload a sample "
                    "of this file to https://streams.videolan.org/upload/ "
                    "and contact the ffmpeg-devel mailing list. (ffmpeg-devel@ffmpeg.org)\n",
-                   ist->dec_ctx->has_b_frames,
+                   params.has_b_frames,
                    ist->par->video_delay);
     }
 
@@ -2447,16 +3550,16 @@ static int decode_video(InputStream *ist, AVPacket *pkt, int *got_output, int64_
         check_decode_result(ist, got_output, ret);
 
     if (*got_output && ret >= 0) {
-        if (ist->dec_ctx->width  != decoded_frame->width ||
-            ist->dec_ctx->height != decoded_frame->height ||
-            ist->dec_ctx->pix_fmt != decoded_frame->format) {
+        if (params.width   != decoded_frame->width ||
+            params.height  != decoded_frame->height ||
+            params.pix_fmt != decoded_frame->format) {
             av_log(NULL, AV_LOG_DEBUG, "Frame parameters mismatch context %d,%d,%d != %d,%d,%d\n",
                 decoded_frame->width,
                 decoded_frame->height,
                 decoded_frame->format,
-                ist->dec_ctx->width,
-                ist->dec_ctx->height,
-                ist->dec_ctx->pix_fmt);
+                params.width,
+                params.height,
+                params.pix_fmt);
         }
     }
 
@@ -2709,8 +3812,15 @@ static int transcode_subtitles(InputStream *ist, const AVPacket *pkt,
                                int *got_output, int *decode_failed)
 {
     AVSubtitle subtitle;
-    int ret = avcodec_decode_subtitle2(ist->dec_ctx,
-                                       &subtitle, got_output, pkt);
+    StageTimer timer;
+    int64_t trace_start;
+    int ret;
+
+    trace_start = trace_span_begin();
+    stage_timer_start(&timer);
+    ret = avcodec_decode_subtitle2(ist->dec_ctx, &subtitle, got_output, pkt);
+    stage_timer_stop(&timer, &ist->decode_time);
+    trace_span_end("decode", trace_start);
 
     check_decode_result(NULL, got_output, ret);
 
@@ -2742,18 +3852,20 @@ static int send_filter_eof(InputStream *ist)
 }
 
 /* pkt = NULL means EOF (needed to flush decoder buffers) */
-static int process_input_packet(InputStream *ist, const AVPacket *pkt, int no_eof)
+static int handle_input_packet(InputStream *ist, const AVPacket *pkt, int no_eof)
 {
     const AVCodecParameters *par = ist->par;
     int ret = 0;
     int repeating = 0;
     int eof_reached = 0;
+    DecoderParams params;
 
     AVPacket *avpkt = ist->pkt;
 
     if (!ist->saw_first_ts) {
+        dec_get_params(ist, &params);
         ist->first_dts =
-        ist->dts = ist->st->avg_frame_rate.num ? - ist->dec_ctx->has_b_frames * AV_TIME_BASE / av_q2d(ist->st->avg_frame_rate) : 0;
+        ist->dts = ist->st->avg_frame_rate.num ? - params.has_b_frames * AV_TIME_BASE / av_q2d(ist->st->avg_frame_rate) : 0;
         ist->pts = 0;
         if (pkt && pkt->pts != AV_NOPTS_VALUE && !ist->decoding_needed) {
             ist->first_dts =
@@ -2801,15 +3913,16 @@ static int process_input_packet(InputStream *ist, const AVPacket *pkt, int no_eo
             ret = decode_video    (ist, repeating ? NULL : avpkt, &got_output, &duration_pts, !pkt,
                                    &decode_failed);
             if (!repeating || !pkt || got_output) {
+                dec_get_params(ist, &params);
                 if (pkt && pkt->duration) {
                     duration_dts = av_rescale_q(pkt->duration, ist->st->time_base, AV_TIME_BASE_Q);
-                } else if(ist->dec_ctx->framerate.num != 0 && ist->dec_ctx->framerate.den != 0) {
+                } else if(params.framerate.num != 0 && params.framerate.den != 0) {
                     int ticks = ist->last_pkt_repeat_pict >= 0 ?
                                 ist->last_pkt_repeat_pict + 1  :
-                                ist->dec_ctx->ticks_per_frame;
+                                params.ticks_per_frame;
                     duration_dts = ((int64_t)AV_TIME_BASE *
-                                    ist->dec_ctx->framerate.den * ticks) /
-                                    ist->dec_ctx->framerate.num / ist->dec_ctx->ticks_per_frame;
+                                    params.framerate.den * ticks) /
+                                    params.framerate.num / params.ticks_per_frame;
                 }
 
                 if(ist->dts != AV_NOPTS_VALUE && duration_dts) {
@@ -2934,6 +4047,156 @@ static int process_input_packet(InputStream *ist, const AVPacket *pkt, int no_eo
     return !eof_reached;
 }
 
+/*
+ * Run the decoding code of the transcode thread for the oldest packet queued
+ * to the decoder thread. Unless block is set, this only happens when all of
+ * its frames are already available.
+ *
+ * @return 1 if a packet was processed, 0 otherwise
+ */
+static int dec_thread_process_pending(InputStream *ist, int block)
+{
+    DecoderThread *dt = ist->dec_thread;
+    DecoderPending pending;
+
+    if (av_fifo_peek(dt->pending, &pending, 1, 0) < 0)
+        return 0;
+
+    if (pending.sent && !block &&
+        atomic_load(&dt->packets_decoded) <= dt->packets_processed)
+        return 0;
+
+    av_fifo_drain2(dt->pending, 1);
+
+    handle_input_packet(ist, pending.pkt, 0);
+    if (pending.sent)
+        dt->packets_processed++;
+
+    av_packet_free(&pending.pkt);
+
+    return 1;
+}
+
+/*
+ * Return the dts decode_video() would give the packet, in stream time base.
+ * The transcode thread only reaches decode_video() once the decoder thread
+ * has decoded the packet, so the prediction of ist->dts and ist->next_dts is
+ * repeated here at send time, using the same rules as handle_input_packet().
+ * Extra frames returned for a single packet do not advance this prediction.
+ */
+static int64_t dec_thread_predict_dts(InputStream *ist, const AVPacket *pkt)
+{
+    DecoderThread *dt = ist->dec_thread;
+    int64_t dts, duration_dts = 0;
+
+    if (!dt->saw_first_ts) {
+        dt->next_dts = ist->st->avg_frame_rate.num ? - dt->params.has_b_frames * AV_TIME_BASE / av_q2d(ist->st->avg_frame_rate) : 0;
+        dt->saw_first_ts = 1;
+    }
+
+    if (pkt->dts != AV_NOPTS_VALUE)
+        dt->next_dts = av_rescale_q(pkt->dts, ist->st->time_base, AV_TIME_BASE_Q);
+    dts = dt->next_dts;
+
+    if (pkt->duration) {
+        duration_dts = av_rescale_q(pkt->duration, ist->st->time_base, AV_TIME_BASE_Q);
+    } else if (dt->params.framerate.num != 0 && dt->params.framerate.den != 0) {
+        int ticks = ist->last_pkt_repeat_pict >= 0 ?
+                    ist->last_pkt_repeat_pict + 1  :
+                    dt->params.ticks_per_frame;
+        duration_dts = ((int64_t)AV_TIME_BASE *
+                        dt->params.framerate.den * ticks) /
+                        dt->params.framerate.num / dt->params.ticks_per_frame;
+    }
+
+    if (dts != AV_NOPTS_VALUE && duration_dts)
+        dt->next_dts += duration_dts;
+    else
+        dt->next_dts = AV_NOPTS_VALUE;
+
+    return dts != AV_NOPTS_VALUE ? av_rescale_q(dts, AV_TIME_BASE_Q, ist->st->time_base) : AV_NOPTS_VALUE;
+}
+
+/*
+ * Queue a packet to the decoder thread of the input stream. Frames are passed
+ * to the filters once the decoder thread returns them, so the decoders of
+ * different streams run in parallel with each other and with the rest of the
+ * transcode loop. On EOF, the frames of all queued packets are processed
+ * first and the remaining frames are returned one per call as before.
+ */
+static int dec_thread_send_packet(InputStream *ist, const AVPacket *pkt, int no_eof)
+{
+    DecoderThread *dt = ist->dec_thread;
+    DecoderPending pending;
+    int64_t dts = AV_NOPTS_VALUE;
+    int ret;
+
+    if (!pkt) {
+        while (dec_thread_process_pending(ist, 1));
+
+        if (!dt->flush_pending) {
+            ret = tq_send(dt->queue_in, 1, dt->pkt);
+            if (ret < 0)
+                return 0;
+            dt->flush_pending = 1;
+        }
+
+        ret = handle_input_packet(ist, NULL, no_eof);
+        if (!ret)
+            dt->flush_pending = 0;
+
+        return ret;
+    }
+
+    while (av_fifo_can_read(dt->pending) >= DEC_THREAD_QUEUE_SIZE)
+        dec_thread_process_pending(ist, 1);
+
+    pending.pkt = av_packet_alloc();
+    if (!pending.pkt)
+        return AVERROR(ENOMEM);
+
+    ret = av_packet_ref(pending.pkt, pkt);
+    if (ret < 0)
+        goto fail;
+
+    pending.sent = ist->par->codec_type != AVMEDIA_TYPE_VIDEO || pkt->size;
+    if (ist->par->codec_type == AVMEDIA_TYPE_VIDEO)
+        dts = dec_thread_predict_dts(ist, pkt);
+    if (pending.sent) {
+        ret = av_packet_ref(dt->pkt, pkt);
+        if (ret < 0)
+            goto fail;
+        if (ist->par->codec_type == AVMEDIA_TYPE_VIDEO)
+            dt->pkt->dts = dts; // as decode_video() does on the synchronous path
+
+        ret = tq_send(dt->queue_in, 0, dt->pkt);
+        if (ret < 0) {
+            av_packet_unref(dt->pkt);
+            goto fail;
+        }
+    }
+
+    ret = av_fifo_write(dt->pending, &pending, 1);
+    if (ret < 0)
+        report_and_exit(ret);
+
+    while (dec_thread_process_pending(ist, 0));
+
+    return 1;
+fail:
+    av_packet_free(&pending.pkt);
+    return ret;
+}
+
+/* pkt = NULL means EOF (needed to flush decoder buffers) */
+static int process_input_packet(InputStream *ist, const AVPacket *pkt, int no_eof)
+{
+    if (ist->dec_thread)
+        return dec_thread_send_packet(ist, pkt, no_eof);
+
+    return handle_input_packet(ist, pkt, no_eof);
+}
+
 static enum AVPixelFormat get_format(AVCodecContext *s, const enum AVPixelFormat *pix_fmts)
 {
     InputStream *ist = s->opaque;
@@ -3492,6 +4755,16 @@ static int init_output_stream(OutputStream *ost, AVFrame *frame,
         // copy estimated duration as a hint to the muxer
         if (ost->st->duration <= 0 && ist && ist->st->duration > 0)
             ost->st->duration = av_rescale_q(ist->st->duration, ist->st->time_base, ost->st->time_base);
+
+        if (enc_thread_supported(ost)) {
+            ret = enc_thread_start(ost);
+            if (ret < 0) {
+                snprintf(error, error_len, "Error starting encoder thread for "
+                         "output stream #%d:%d : %s",
+                         ost->file_index, ost->index, av_err2str(ret));
+                return ret;
+            }
+        }
     } else if (ost->ist) {
         ret = init_output_stream_streamcopy(ost);
         if (ret < 0)
@@ -3523,6 +4796,29 @@ static int transcode_init(void)
         if ((ret = init_input_stream(ist, error, sizeof(error))) < 0)
             goto dump_format;
 
+    /* start decoder threads */
+    for (InputStream *ist = ist_iter(NULL); ist; ist = ist_iter(ist)) {
+        if (!dec_thread_supported(ist))
+            continue;
+
+        if ((ret = dec_thread_start(ist)) < 0) {
+            snprintf(error, sizeof(error), "Error starting decoder thread for input stream #%d:%d : %s",
+                     ist->file_index, ist->st->index, av_err2str(ret));
+            goto dump_format;
+        }
+    }
+
+    /* start filtergraph threads, a single graph has nothing to run concurrently with */
+    if (filtergraph_parallel && nb_filtergraphs > 1) {
+        for (int i = 0; i < nb_filtergraphs; i++) {
+            if ((ret = fg_thread_start(filtergraphs[i])) < 0) {
+                snprintf(error, sizeof(error), "Error starting thread for filtergraph #%d : %s",
+                         i, av_err2str(ret));
+                goto dump_format;
+            }
+        }
+    }
+
     /*
      * initialize stream copy and subtitle/data streams.
      * Encoded AVFrame based streams will get initialized as follows:
@@ -3662,7 +4958,98 @@ static int need_output(void)
  *
  * @return  selected output stream, or NULL if none available
  */
-static OutputStream *choose_output(void)
+static int64_t ost_heap_ts(const OutputStream *ost)
+{
+    if (ost->filter && ost->last_filter_pts != AV_NOPTS_VALUE)
+        return ost->last_filter_pts;
+    return ost->last_mux_dts == AV_NOPTS_VALUE ? INT64_MIN : ost->last_mux_dts;
+}
+
+/* ties are broken in ost_iter() order, as the linear scan did */
+static int ost_heap_less(const OutputStream *a, const OutputStream *b)
+{
+    int64_t ts_a = ost_heap_ts(a), ts_b = ost_heap_ts(b);
+
+    if (ts_a != ts_b)
+        return ts_a < ts_b;
+    if (a->file_index != b->file_index)
+        return a->file_index < b->file_index;
+    return a->index < b->index;
+}
+
+static void ost_heap_set(int idx, OutputStream *ost)
+{
+    ost_heap[idx]  = ost;
+    ost->heap_idx  = idx;
+}
+
+static void ost_heap_sift_up(int idx)
+{
+    OutputStream *ost = ost_heap[idx];
+
+    while (idx > 0) {
+        int parent = (idx - 1) / 2;
+        if (!ost_heap_less(ost, ost_heap[parent]))
+            break;
+        ost_heap_set(idx, ost_heap[parent]);
+        idx = parent;
+    }
+    ost_heap_set(idx, ost);
+}
+
+static void ost_heap_sift_down(int idx)
+{
+    OutputStream *ost = ost_heap[idx];
+
+    while (1) {
+        int child = 2 * idx + 1;
+        if (child >= nb_ost_heap)
+            break;
+        if (child + 1 < nb_ost_heap && ost_heap_less(ost_heap[child + 1], ost_heap[child]))
+            child++;
+        if (!ost_heap_less(ost_heap[child], ost))
+            break;
+        ost_heap_set(idx, ost_heap[child]);
+        idx = child;
+    }
+    ost_heap_set(idx, ost);
+}
+
+static int ost_heap_init(void)
+{
+    int nb_ost = 0;
+
+    for (OutputStream *ost = ost_iter(NULL); ost; ost = ost_iter(ost))
+        nb_ost++;
+
+    ost_heap = av_malloc_array(FFMAX(nb_ost, 1), sizeof(*ost_heap));
+    if (!ost_heap)
+        return AVERROR(ENOMEM);
+
+    nb_ost_heap = 0;
+    for (OutputStream *ost = ost_iter(NULL); ost; ost = ost_iter(ost)) {
+        if (ost->finished)
+            continue;
+        ost_heap_set(nb_ost_heap, ost);
+        ost_heap_sift_up(nb_ost_heap++);
+    }
+
+    return 0;
+}
+
+void ost_heap_update(OutputStream *ost)
+{
+    int idx = ost->heap_idx;
+
+    if (idx < 0 || idx >= nb_ost_heap || ost_heap[idx] != ost)
+        return;
+
+    ost_heap_sift_up(idx);
+    ost_heap_sift_down(ost->heap_idx);
+}
+
+/* linear scan, used until all output streams are started */
+static OutputStream *choose_output_scan(void)
 {
     int64_t opts_min = INT64_MAX;
     OutputStream *ost_min = NULL;
@@ -3692,6 +5079,44 @@ static OutputStream *choose_output(void)
     return ost_min;
 }
 
+/*
+ * Select the output stream to process, the one with the lowest timestamp.
+ *
+ * Streams not initialized yet come first, in order. Once every stream is
+ * started the choice is taken from ost_heap, which reap_filters() and
+ * of_output_packet() keep ordered through ost_heap_update().
+ */
+static OutputStream *choose_output(void)
+{
+    OutputStream *ost;
+
+    if (!ost_heap) {
+        for (ost = ost_iter(NULL); ost; ost = ost_iter(ost))
+            if (!ost->initialized && !ost->inputs_done)
+                return choose_output_scan();
+
+        if (ost_heap_init() < 0)
+            return choose_output_scan();
+    }
+
+    /* finished streams are dropped once they reach the top */
+    while (nb_ost_heap && ost_heap[0]->finished) {
+        ost_heap_set(0, ost_heap[--nb_ost_heap]);
+        if (nb_ost_heap)
+            ost_heap_sift_down(0);
+    }
+    if (!nb_ost_heap)
+        return NULL;
+
+    ost = ost_heap[0];
+    if (ost->last_mux_dts == AV_NOPTS_VALUE && ost_heap_ts(ost) == INT64_MIN)
+        av_log(ost, AV_LOG_DEBUG,
+            "cur_dts is invalid [init:%d i_done:%d finish:%d] (this is harmless if it occurs once at the start per stream)\n",
+            ost->initialized, ost->inputs_done, ost->finished);
+
+    return ost->unavailable ? NULL : ost;
+}
+
 static void set_tty_echo(int on)
 {
 #if HAVE_TERMIOS_H
@@ -3742,6 +5167,7 @@ static int check_keyboard_interaction(int64_t cur_time)
             for (i = 0; i < nb_filtergraphs; i++) {
                 FilterGraph *fg = filtergraphs[i];
                 if (fg->graph) {
+                    fg_thread_wait(fg);
                     if (time < 0) {
                         ret = avfilter_graph_send_command(fg->graph, target, command, arg, buf, sizeof(buf),
                                                           key == 'c' ? AVFILTER_CMD_FLAG_ONE : 0);
@@ -3846,16 +5272,21 @@ static void decode_flush(InputFile *ifile)
             /* report last frame duration to the demuxer thread */
             if (ist->par->codec_type == AVMEDIA_TYPE_AUDIO) {
                 LastFrameDuration dur;
+                DecoderParams params;
+
+                dec_get_params(ist, &params);
 
                 dur.stream_idx = i;
                 dur.duration   = av_rescale_q(ist->nb_samples,
-                                              (AVRational){ 1, ist->dec_ctx->sample_rate},
+                                              (AVRational){ 1, params.sample_rate},
                                               ist->st->time_base);
 
                 av_thread_message_queue_send(ifile->audio_duration_queue, &dur, 0);
             }
 
-            avcodec_flush_buffers(ist->dec_ctx);
+            /* decoder threads reset their decoder after draining it */
+            if (!ist->dec_thread)
+                avcodec_flush_buffers(ist->dec_ctx);
         }
     }
 }
@@ -4049,7 +5480,7 @@ static int process_input(int file_index)
     process_input_packet(ist, pkt, 0);
 
 discard_packet:
-    av_packet_free(&pkt);
+    ifile_release_packet(ifile, &pkt);
 
     return 0;
 }
@@ -4069,6 +5500,8 @@ static int transcode_from_filter(FilterGraph *graph, InputStream **best_ist)
     InputStream *ist;
 
     *best_ist = NULL;
+    if ((ret = fg_thread_wait(graph)) < 0)
+        return ret;
     ret = avfilter_graph_request_oldest(graph->graph);
     if (ret >= 0)
         return reap_filters(0);
@@ -4117,7 +5550,8 @@ static int transcode_step(void)
     if (!ost) {
         if (got_eagain()) {
             reset_eagain();
-            av_usleep(10000);
+            /* woken up early when a demuxer thread queues a packet */
+            ifile_wait_packet(10000);
             return 0;
         }
         av_log(NULL, AV_LOG_VERBOSE, "No more inputs to read from, finishing.\n");
@@ -4181,6 +5615,10 @@ static int transcode_step(void)
         av_assert0(ist);
     }
 
+    /* frames already decoded on the decoder thread come before reading new packets */
+    if (ist->dec_thread && dec_thread_process_pending(ist, 0))
+        return reap_filters(0);
+
     ret = process_input(ist->file_index);
     if (ret == AVERROR(EAGAIN)) {
         if (input_files[ist->file_index]->eagain)
@@ -4365,6 +5803,52 @@ void ffmpeg_var_cleanup() {
     for(int i = 0; i < FF_ARRAY_ELEMS(qp_histogram); i++) {
         qp_histogram[i] = 0;
     }
+
+    /* option variables, threads are reused by consecutive sessions */
+    hw_device_free_all();
+    filter_hw_device = NULL;
+
+    av_freep(&vstats_filename);
+    av_freep(&trace_filename);
+    av_freep(&sdp_filename);
+
+    audio_drift_threshold = 0.1;
+    dts_delta_threshold   = 10;
+    dts_error_threshold   = 3600*30;
+
+    video_sync_method = VSYNC_AUTO;
+    frame_drop_threshold = 0;
+    do_benchmark      = 0;
+    do_benchmark_all  = 0;
+    do_hex_dump       = 0;
+    do_pkt_dump       = 0;
+    copy_ts           = 0;
+    start_at_zero     = 0;
+    copy_tb           = -1;
+    debug_ts          = 0;
+    exit_on_error     = 0;
+    abort_on_flags    = 0;
+    print_stats       = -1;
+    qp_hist           = 0;
+    stdin_interaction = 1;
+    max_error_rate    = 2.0/3;
+    av_freep(&filter_nbthreads);
+    filter_complex_nbthreads = 0;
+    vstats_version = 2;
+    auto_conversion_filters = 1;
+    threaded_decoding = 1;
+    threaded_encoding = 1;
+    filtergraph_parallel = 0;
+    stats_period = 500000;
+
+    file_overwrite     = 0;
+    no_file_overwrite  = 0;
+    do_psnr            = 0;
+    ignore_unknown_streams = 0;
+    copy_unknown_streams = 0;
+    recast_media = 0;
+
+    hide_banner = 0;
 }
 
 void set_report_callback(void (*callback)(int, float, float, int64_t, double, double, double))
@@ -4372,6 +5856,12 @@ void set_report_callback(void (*callback)(int, float, float, int64_t, double, do
     report_callback = callback;
 }
 
+void set_stream_report_callback(void (*callback)(const StreamReport *reports, int nb_reports))
+{
+    stream_report_callback = callback;
+    atomic_store(&stage_timing, callback != NULL);
+}
+
 void cancel_operation(long id)
 {
     if (id == 0) {
@@ -4507,6 +5997,8 @@ int ffmpeg_execute(int argc, char **argv)
             "set the number of data frames to output", "number" },
         { "benchmark",      OPT_BOOL | OPT_EXPERT,                       { &do_benchmark },
             "add timings for benchmarking" },
+        { "trace_file",     HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_trace_file },
+            "write a Chrome trace of the decode, filter, encode and mux threads to file", "file" },
         { "benchmark_all",  OPT_BOOL | OPT_EXPERT,                       { &do_benchmark_all },
           "add timings for each task" },
         { "progress",       HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_progress },
@@ -4595,6 +6087,12 @@ int ffmpeg_execute(int argc, char **argv)
             "read complex filtergraph description from a file", "filename" },
         { "auto_conversion_filters", OPT_BOOL | OPT_EXPERT,              { &auto_conversion_filters },
             "enable automatic conversion filters globally" },
+        { "threaded_decoding", OPT_BOOL | OPT_EXPERT,                    { &threaded_decoding },
+            "decode audio and video input streams on their own threads" },
+        { "threaded_encoding", OPT_BOOL | OPT_EXPERT,                    { &threaded_encoding },
+            "encode audio and video output streams on their own threads" },
+        { "filtergraph_parallel", OPT_BOOL | OPT_EXPERT,                 { &filtergraph_parallel },
+            "run each filtergraph on its own thread" },
         { "stats",          OPT_BOOL,                                    { &print_stats },
             "print progress report during encoding", },
         { "stats_period",    HAS_ARG | OPT_EXPERT,                       { .func_arg = opt_stats_period },
@@ -4620,6 +6118,12 @@ int ffmpeg_execute(int argc, char **argv)
         { "thread_queue_size", HAS_ARG | OPT_INT | OPT_OFFSET | OPT_EXPERT | OPT_INPUT | OPT_OUTPUT,
                                                                          { .off = OFFSET(thread_queue_size) },
             "set the maximum number of queued packets from the demuxer" },
+        { "eagain_backoff_min", HAS_ARG | OPT_TIME | OPT_OFFSET | OPT_EXPERT | OPT_INPUT,
+                                                                         { .off = OFFSET(eagain_backoff_min) },
+            "set the first delay before reading again from an input that returned EAGAIN", "duration" },
+        { "eagain_backoff_max", HAS_ARG | OPT_TIME | OPT_OFFSET | OPT_EXPERT | OPT_INPUT,
+                                                                         { .off = OFFSET(eagain_backoff_max) },
+            "set the longest delay before reading again from an input that returned EAGAIN", "duration" },
         { "find_stream_info", OPT_BOOL | OPT_INPUT | OPT_EXPERT | OPT_OFFSET, { .off = OFFSET(find_stream_info) },
             "read and decode the streams to fill missing information with heuristics" },
         { "bits_per_raw_sample", OPT_INT | HAS_ARG | OPT_EXPERT | OPT_SPEC | OPT_OUTPUT,
@@ -4638,6 +6142,8 @@ int ffmpeg_execute(int argc, char **argv)
             "format of the stats written with -stats_enc_post" },
         { "stats_mux_pre_fmt",  HAS_ARG | OPT_SPEC | OPT_EXPERT | OPT_OUTPUT | OPT_STRING, { .off = OFFSET(mux_stats_fmt)      },
             "format of the stats written with -stats_mux_pre" },
+        { "stats_binary",       OPT_BOOL | OPT_OFFSET | OPT_EXPERT | OPT_OUTPUT,           { .off = OFFSET(stats_binary)       },
+            "write the -stats_enc_pre/-stats_enc_post/-stats_mux_pre stats as fixed-width binary records" },
 
         /* video options */
         { "vframes",      OPT_VIDEO | HAS_ARG  | OPT_PERFILE | OPT_OUTPUT,           { .func_arg = opt_video_frames },
@@ -4897,6 +6403,9 @@ int ffmpeg_execute(int argc, char **argv)
             exit_program(1);
         }
 
+        if (trace_filename && trace_session_init(trace_filename) < 0)
+            exit_program(1);
+
         current_time = ti = get_benchmark_time_stamps();
         if (transcode() < 0)
             exit_program(1);
@@ -25,6 +25,19 @@
  *
  * ffmpeg-kit changes by ARTHENICA LTD
  *
+ * 10.2026
+ * --------------------------------------------------------
+ * - dec_thread field added to InputStream, threaded_decoding option and dec_thread_stop() declared
+ * - enc_thread field added to OutputStream, threaded_encoding option and enc_thread_stop() declared
+ * - thread field added to FilterGraph, filtergraph_parallel option and fg_thread_*() functions declared
+ * - heap_idx field added to OutputStream, ost_heap_update() and ifile_wait_packet() declared
+ * - eagain_backoff_min and eagain_backoff_max input options added to OptionsContext
+ * - ifile_release_packet() declared
+ * - StageTime added, fftools_stream_report.h included, per stream counters and stage times added to InputStream and OutputStream,
+ *   stage_timer_*(), ifile_queue_depth() and of_queue_depth() declared
+ * - stats_binary output option added to OptionsContext, binary and flush_time fields added to EncStats
+ * - fftools_trace.h included, trace_filename declared
+ *
  * 07.2023
  * --------------------------------------------------------
  * - FFmpeg 6.0 changes migrated
@@ -76,7 +89,9 @@
 #include <signal.h>
 
 #include "fftools_cmdutils.h"
+#include "fftools_stream_report.h"
 #include "fftools_sync_queue.h"
+#include "fftools_trace.h"
 
 #include "libavformat/avformat.h"
 #include "libavformat/avio.h"
@@ -175,6 +190,8 @@ typedef struct OptionsContext {
     float readrate;
     int accurate_seek;
     int thread_queue_size;
+    int64_t eagain_backoff_min;
+    int64_t eagain_backoff_max;
     int input_sync_ref;
     int find_stream_info;
 
@@ -315,6 +332,7 @@ typedef struct OptionsContext {
     int        nb_enc_stats_post_fmt;
     SpecifierOpt *mux_stats_fmt;
     int        nb_mux_stats_fmt;
+    int stats_binary;
 } OptionsContext;
 
 typedef struct InputFilter {
@@ -365,6 +383,8 @@ typedef struct OutputFilter {
     const int *sample_rates;
 } OutputFilter;
 
+typedef struct FilterGraphThread FilterGraphThread;
+
 typedef struct FilterGraph {
     int            index;
     const char    *graph_desc;
@@ -379,8 +399,27 @@ typedef struct FilterGraph {
     int          nb_inputs;
     OutputFilter **outputs;
     int         nb_outputs;
+
+    /* thread pushing frames through the graph, NULL when filtering on the transcode thread */
+    FilterGraphThread *thread;
 } FilterGraph;
 
+/*
+ * Wall and CPU time spent in a processing stage, in microseconds. Only
+ * measured while a stream report callback is set, see stage_timer_start().
+ */
+typedef struct StageTime {
+    atomic_int_least64_t wall;
+    atomic_int_least64_t cpu;
+} StageTime;
+
+typedef struct StageTimer {
+    int64_t wall;
+    int64_t cpu;
+} StageTimer;
+
+typedef struct DecoderThread DecoderThread;
+
 typedef struct InputStream {
     int file_index;
     AVStream *st;
@@ -484,11 +523,20 @@ typedef struct InputStream {
     // number of frames/samples retrieved from the decoder
     uint64_t frames_decoded;
     uint64_t samples_decoded;
+    // number of decoded frames sent to the filters
+    uint64_t frames_filtered;
+
+    StageTime decode_time;
+    // time spent in the filtergraphs while adding frames from this stream
+    StageTime filter_time;
 
     int64_t *dts_buffer;
     int nb_dts_buffer;
 
     int got_output;
+
+    /* decoder running on its own thread, NULL when decoding on the transcode thread */
+    DecoderThread *dec_thread;
 } InputStream;
 
 typedef struct LastFrameDuration {
@@ -578,6 +626,11 @@ typedef struct EncStats {
     int              nb_components;
 
     AVIOContext        *io;
+
+    /* write fixed-width little-endian records instead of formatted text */
+    int                 binary;
+    /* last time io was flushed, see ENC_STATS_FLUSH_INTERVAL */
+    int64_t             flush_time;
 } EncStats;
 
 extern const char *const forced_keyframes_const_names[];
@@ -608,6 +661,8 @@ typedef struct KeyframeForceCtx {
     int          dropped_keyframe;
 } KeyframeForceCtx;
 
+typedef struct EncoderThread EncoderThread;
+
 typedef struct OutputStream {
     const AVClass *clazz;
 
@@ -629,6 +684,8 @@ typedef struct OutputStream {
     int64_t last_mux_dts;
     /* pts of the last frame received from the filters, in AV_TIME_BASE_Q */
     int64_t last_filter_pts;
+    /* position in the choose_output() heap, see ost_heap_update() */
+    int heap_idx;
 
     // timestamp from which the streamcopied streams should start,
     // in AV_TIME_BASE_Q;
@@ -715,6 +772,16 @@ typedef struct OutputStream {
     uint64_t samples_encoded;
     // number of packets received from the encoder
     uint64_t packets_encoded;
+    // number of frames received from the filters
+    uint64_t frames_filtered;
+    // number of frames duplicated and dropped by the video sync code
+    int64_t nb_frames_dup;
+    int64_t nb_frames_drop;
+
+    // time spent in the filtergraph while getting frames for this stream
+    StageTime filter_time;
+    StageTime encode_time;
+    StageTime mux_time;
 
     /* packet quality factor */
     int quality;
@@ -736,6 +803,9 @@ typedef struct OutputStream {
      * subtitles utilizing fix_sub_duration at random access points.
      */
     unsigned int fix_sub_duration_heartbeat;
+
+    /* encoder running on its own thread, NULL when encoding on the transcode thread */
+    EncoderThread *enc_thread;
 } OutputStream;
 
 typedef struct OutputFile {
@@ -768,6 +838,7 @@ extern __thread FilterGraph **filtergraphs;
 extern __thread int        nb_filtergraphs;
 
 extern __thread char *vstats_filename;
+extern __thread char *trace_filename;
 extern __thread char *sdp_filename;
 
 extern __thread float audio_drift_threshold;
@@ -797,6 +868,9 @@ extern __thread char *filter_nbthreads;
 extern __thread int filter_complex_nbthreads;
 extern __thread int vstats_version;
 extern __thread int auto_conversion_filters;
+extern __thread int threaded_decoding;
+extern __thread int threaded_encoding;
+extern __thread int filtergraph_parallel;
 
 extern __thread const AVIOInterruptCB int_cb;
 
@@ -839,6 +913,21 @@ void sub2video_update(InputStream *ist, int64_t heartbeat_pts, AVSubtitle *sub);
 
 int ifilter_parameters_from_frame(InputFilter *ifilter, const AVFrame *frame);
 
+int fg_thread_start(FilterGraph *fg);
+void fg_thread_stop(FilterGraph *fg);
+/*
+ * Wait until the thread of the filtergraph, if any, has pushed its pending
+ * frame. Must be called before the graph is accessed on the transcode thread.
+ *
+ * @return 0 or the first error the thread got from the graph
+ */
+int fg_thread_wait(FilterGraph *fg);
+/*
+ * Hand a frame over to the thread of the filtergraph of ifilter. The frame is
+ * referenced when keep_reference is set, otherwise its reference is moved.
+ */
+int fg_thread_send_frame(InputFilter *ifilter, AVFrame *frame, int keep_reference);
+
 int ffmpeg_parse_options(int argc, char **argv);
 
 void enc_stats_write(OutputStream *ost, EncStats *es,
@@ -855,6 +944,18 @@ int hw_device_setup_for_filter(FilterGraph *fg);
 
 int hwaccel_decode_init(AVCodecContext *avctx);
 
+/*
+ * Stop the decoder thread of the given input stream, if it has one. Frames and
+ * packets still queued are dropped.
+ */
+void dec_thread_stop(InputStream *ist);
+
+/*
+ * Stop the encoder thread of the given output stream, if it has one. Packets
+ * not yet output are dropped.
+ */
+void enc_thread_stop(OutputStream *ost);
+
 /*
  * Initialize muxing state for the given stream, should be called
  * after the codec/streamcopy setup has been done.
@@ -896,11 +997,48 @@ void ifile_close(InputFile **f);
  * - a negative error code on failure
  */
 int ifile_get_packet(InputFile *f, AVPacket **pkt);
+/**
+ * Return a packet obtained from ifile_get_packet() to the demuxer, so that it
+ * can be reused for a later packet.
+ */
+void ifile_release_packet(InputFile *f, AVPacket **pkt);
+
+/**
+ * Wait until a demuxer thread has queued a packet or terminated since the
+ * previous call, but no longer than timeout microseconds.
+ */
+void ifile_wait_packet(int64_t timeout);
+void ifile_wait_packet_uninit(void);
+
+/**
+ * Restore the position of ost in the choose_output() heap. Must be called
+ * whenever last_filter_pts or last_mux_dts of ost changes.
+ */
+void ost_heap_update(OutputStream *ost);
 
 /* iterate over all input streams in all input files;
  * pass NULL to start iteration */
 InputStream *ist_iter(InputStream *prev);
 
+/*
+ * Start measuring a processing stage on the calling thread, does nothing when
+ * no stream report callback is set.
+ */
+void stage_timer_start(StageTimer *timer);
+/*
+ * Add the time passed since stage_timer_start() to time.
+ */
+void stage_timer_stop(const StageTimer *timer, StageTime *time);
+
+/**
+ * Number of packets waiting in the demuxer thread queue of f.
+ */
+int ifile_queue_depth(InputFile *f);
+/**
+ * Number of packets waiting in the muxer thread queue of of.
+ */
+int of_queue_depth(OutputFile *of);
+
 extern const char * const opt_name_codec_names[];
 extern const char * const opt_name_codec_tags[];
 extern const char * const opt_name_frame_rates[];
@@ -25,6 +25,15 @@
  *
  * ffmpeg-kit changes by ARTHENICA LTD
  *
+ * 10.2026
+ * --------------------------------------------------------
+ * - decoder thread stopped before the decoder context is freed
+ * - demuxer threads signal a PacketWakeup, see ifile_wait_packet()
+ * - fixed 10 ms sleep after EAGAIN replaced with an interruptible backoff, see eagain_backoff()
+ * - packets sent to the transcode thread are taken from the session packet pool, see ifile_release_packet()
+ * - ifile_queue_depth() added
+ * - av_read_frame() calls of the demuxer threads traced when -trace_file is set
+ *
  * 07.2023
  * --------------------------------------------------------
  * - FFmpeg 6.0 changes migrated
@@ -37,6 +46,7 @@
 
 #include "fftools_ffmpeg.h"
 #include "fftools_ffmpeg_mux.h"
+#include "fftools_objpool.h"
 
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
@@ -84,11 +94,38 @@ typedef struct Demuxer {
     int nb_streams_warn;
 
     AVThreadMessageQueue *in_thread_queue;
+    /* packets sent through in_thread_queue, returned by ifile_release_packet() */
+    ObjPool              *pkt_pool;
     int                   thread_queue_size;
     pthread_t             thread;
     int                   non_blocking;
+
+    struct PacketWakeup  *wakeup;
+
+    /* tracer of the session, captured for the demuxer thread */
+    Tracer               *tracer;
+
+    /* delay between av_read_frame() retries after EAGAIN, doubled on every
+     * retry from eagain_backoff_min up to eagain_backoff_max */
+    int64_t               eagain_backoff_min;
+    int64_t               eagain_backoff_max;
+    /* lets thread_stop() interrupt the backoff */
+    pthread_mutex_t       stop_lock;
+    pthread_cond_t        stop_cond;
+    int                   stop_lock_initialized;
+    int                   stopping;
 } Demuxer;
 
+/* shared by the demuxer threads of a session, signalled when they queue a packet or stop */
+typedef struct PacketWakeup {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    uint64_t        events;
+} PacketWakeup;
+
+static __thread PacketWakeup *packet_wakeup        = NULL;
+static __thread uint64_t      packet_wakeup_events = 0;
+
 typedef struct DemuxMsg {
     AVPacket *pkt;
     int looping;
@@ -244,6 +281,109 @@ static void ts_fixup(Demuxer *d, AVPacket *pkt, int *repeat_pict)
         *repeat_pict = av_stream_get_parser(ist->st)->repeat_pict;
 }
 
+static int packet_wakeup_init(void)
+{
+    PacketWakeup *pw;
+    int ret;
+
+    if (packet_wakeup)
+        return 0;
+
+    pw = av_mallocz(sizeof(*pw));
+    if (!pw)
+        return AVERROR(ENOMEM);
+
+    if ((ret = pthread_mutex_init(&pw->lock, NULL))) {
+        av_freep(&pw);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&pw->cond, NULL))) {
+        pthread_mutex_destroy(&pw->lock);
+        av_freep(&pw);
+        return AVERROR(ret);
+    }
+
+    packet_wakeup        = pw;
+    packet_wakeup_events = 0;
+
+    return 0;
+}
+
+static void packet_wakeup_signal(PacketWakeup *pw)
+{
+    pthread_mutex_lock(&pw->lock);
+    pw->events++;
+    pthread_cond_signal(&pw->cond);
+    pthread_mutex_unlock(&pw->lock);
+}
+
+void ifile_wait_packet(int64_t timeout)
+{
+    PacketWakeup *pw = packet_wakeup;
+    int64_t deadline;
+    struct timespec ts;
+
+    if (!pw) {
+        av_usleep(timeout);
+        return;
+    }
+
+    deadline   = av_gettime() + timeout;
+    ts.tv_sec  = deadline / 1000000;
+    ts.tv_nsec = (deadline % 1000000) * 1000;
+
+    pthread_mutex_lock(&pw->lock);
+    while (pw->events == packet_wakeup_events) {
+        if (pthread_cond_timedwait(&pw->cond, &pw->lock, &ts))
+            break;
+    }
+    packet_wakeup_events = pw->events;
+    pthread_mutex_unlock(&pw->lock);
+}
+
+/* must be called after all demuxer threads are stopped */
+void ifile_wait_packet_uninit(void)
+{
+    PacketWakeup *pw = packet_wakeup;
+
+    if (!pw)
+        return;
+
+    pthread_cond_destroy(&pw->cond);
+    pthread_mutex_destroy(&pw->lock);
+    av_freep(&packet_wakeup);
+}
+
+/*
+ * Wait before retrying a read that returned EAGAIN. The delay starts small so
+ * that a live input which is only briefly starved is read again quickly, and
+ * grows up to eagain_backoff_max while it stays idle.
+ *
+ * @return 0, or AVERROR_EXIT when the demuxer thread is being stopped
+ */
+static int eagain_backoff(Demuxer *d, int64_t *delay)
+{
+    int64_t deadline;
+    struct timespec ts;
+    int stopping;
+
+    *delay = *delay ? FFMIN(*delay * 2, d->eagain_backoff_max) : d->eagain_backoff_min;
+
+    deadline   = av_gettime() + *delay;
+    ts.tv_sec  = deadline / 1000000;
+    ts.tv_nsec = (deadline % 1000000) * 1000;
+
+    pthread_mutex_lock(&d->stop_lock);
+    while (!d->stopping) {
+        if (pthread_cond_timedwait(&d->stop_cond, &d->stop_lock, &ts))
+            break;
+    }
+    stopping = d->stopping;
+    pthread_mutex_unlock(&d->stop_lock);
+
+    return stopping ? AVERROR_EXIT : 0;
+}
+
 static void thread_set_name(InputFile *f)
 {
     char name[16];
@@ -257,6 +397,7 @@ static void *input_thread(void *arg)
     InputFile *f = &d->f;
     AVPacket *pkt;
     unsigned flags = d->non_blocking ? AV_THREAD_MESSAGE_NONBLOCK : 0;
+    int64_t backoff = 0;
     int ret = 0;
 
     pkt = av_packet_alloc();
@@ -266,21 +407,29 @@ static void *input_thread(void *arg)
     }
 
     thread_set_name(f);
+    trace_thread_init(d->tracer, "demux %d", f->index);
 
     while (1) {
         DemuxMsg msg = { NULL };
+        int64_t trace_start = trace_span_begin();
 
         ret = av_read_frame(f->ctx, pkt);
+        trace_span_end("read", trace_start);
 
         if (ret == AVERROR(EAGAIN)) {
-            av_usleep(10000);
+            if ((ret = eagain_backoff(d, &backoff)) < 0)
+                break;
             continue;
         }
+        backoff = 0;
+
         if (ret < 0) {
             if (d->loop) {
                 /* signal looping to the consumer thread */
                 msg.looping = 1;
                 ret = av_thread_message_queue_send(d->in_thread_queue, &msg, 0);
+                if (ret >= 0)
+                    packet_wakeup_signal(d->wakeup);
                 if (ret >= 0)
                     ret = seek_to_start(d);
                 if (ret >= 0)
@@ -324,10 +473,9 @@ static void *input_thread(void *arg)
 
         ts_fixup(d, pkt, &msg.repeat_pict);
 
-        msg.pkt = av_packet_alloc();
-        if (!msg.pkt) {
+        ret = objpool_get(d->pkt_pool, (void**)&msg.pkt);
+        if (ret < 0) {
             av_packet_unref(pkt);
-            ret = AVERROR(ENOMEM);
             break;
         }
         av_packet_move_ref(msg.pkt, pkt);
@@ -345,19 +493,24 @@ static void *input_thread(void *arg)
                 av_log(f->ctx, AV_LOG_ERROR,
                        "Unable to send packet to main thread: %s\n",
                        av_err2str(ret));
-            av_packet_free(&msg.pkt);
+            objpool_release(d->pkt_pool, (void**)&msg.pkt);
             break;
         }
+
+        packet_wakeup_signal(d->wakeup);
     }
 
 finish:
     av_assert0(ret < 0);
     av_thread_message_queue_set_err_recv(d->in_thread_queue, ret);
+    packet_wakeup_signal(d->wakeup);
 
     av_packet_free(&pkt);
 
     av_log(NULL, AV_LOG_VERBOSE, "Terminating demuxer thread %d\n", f->index);
 
+    trace_thread_uninit();
+
     return NULL;
 }
 
@@ -366,15 +519,28 @@ static void thread_stop(Demuxer *d)
     InputFile *f = &d->f;
     DemuxMsg msg;
 
-    if (!d->in_thread_queue)
-        return;
-    av_thread_message_queue_set_err_send(d->in_thread_queue, AVERROR_EOF);
-    while (av_thread_message_queue_recv(d->in_thread_queue, &msg, 0) >= 0)
-        av_packet_free(&msg.pkt);
+    if (d->in_thread_queue) {
+        pthread_mutex_lock(&d->stop_lock);
+        d->stopping = 1;
+        pthread_cond_signal(&d->stop_cond);
+        pthread_mutex_unlock(&d->stop_lock);
 
-    pthread_join(d->thread, NULL);
-    av_thread_message_queue_free(&d->in_thread_queue);
-    av_thread_message_queue_free(&f->audio_duration_queue);
+        av_thread_message_queue_set_err_send(d->in_thread_queue, AVERROR_EOF);
+        while (av_thread_message_queue_recv(d->in_thread_queue, &msg, 0) >= 0)
+            objpool_release(d->pkt_pool, (void**)&msg.pkt);
+
+        pthread_join(d->thread, NULL);
+        av_thread_message_queue_free(&d->in_thread_queue);
+        objpool_free(&d->pkt_pool);
+        av_thread_message_queue_free(&f->audio_duration_queue);
+    }
+
+    /* also created by a thread_start() call that failed after initializing them */
+    if (d->stop_lock_initialized) {
+        pthread_cond_destroy(&d->stop_cond);
+        pthread_mutex_destroy(&d->stop_lock);
+        d->stop_lock_initialized = 0;
+    }
 }
 
 static int thread_start(Demuxer *d)
@@ -389,10 +555,31 @@ static int thread_start(Demuxer *d)
         (f->ctx->pb ? !f->ctx->pb->seekable :
          strcmp(f->ctx->iformat->name, "lavfi")))
         d->non_blocking = 1;
+    ret = packet_wakeup_init();
+    if (ret < 0)
+        return ret;
+    d->wakeup = packet_wakeup;
+
+    if (!d->stop_lock_initialized) {
+        if ((ret = pthread_mutex_init(&d->stop_lock, NULL)))
+            return AVERROR(ret);
+        if ((ret = pthread_cond_init(&d->stop_cond, NULL))) {
+            pthread_mutex_destroy(&d->stop_lock);
+            return AVERROR(ret);
+        }
+        d->stop_lock_initialized = 1;
+    }
+
+    d->pkt_pool = objpool_session_packets();
+    if (!d->pkt_pool)
+        return AVERROR(ENOMEM);
+
     ret = av_thread_message_queue_alloc(&d->in_thread_queue,
                                         d->thread_queue_size, sizeof(DemuxMsg));
-    if (ret < 0)
+    if (ret < 0) {
+        objpool_free(&d->pkt_pool);
         return ret;
+    }
 
     if (d->loop) {
         int nb_audio_dec = 0;
@@ -412,6 +599,8 @@ static int thread_start(Demuxer *d)
         }
     }
 
+    d->tracer = trace_session();
+
     if ((ret = pthread_create(&d->thread, NULL, input_thread, d))) {
         av_log(NULL, AV_LOG_ERROR, "pthread_create failed: %s. Try to increase `ulimit -v` or decrease `ulimit -s`.\n", strerror(ret));
         ret = AVERROR(ret);
@@ -421,6 +610,7 @@ static int thread_start(Demuxer *d)
     return 0;
 fail:
     av_thread_message_queue_free(&d->in_thread_queue);
+    objpool_free(&d->pkt_pool);
     return ret;
 }
 
@@ -471,6 +661,20 @@ int ifile_get_packet(InputFile *f, AVPacket **pkt)
     return 0;
 }
 
+void ifile_release_packet(InputFile *f, AVPacket **pkt)
+{
+    Demuxer *d = demuxer_from_ifile(f);
+
+    objpool_release(d->pkt_pool, (void**)pkt);
+}
+
+int ifile_queue_depth(InputFile *f)
+{
+    Demuxer *d = demuxer_from_ifile(f);
+
+    return d->in_thread_queue ? av_thread_message_queue_nb_elems(d->in_thread_queue) : 0;
+}
+
 static void ist_free(InputStream **pist)
 {
     InputStream *ist = *pist;
@@ -487,6 +691,7 @@ static void ist_free(InputStream **pist)
     av_freep(&ist->hwaccel_device);
     av_freep(&ist->dts_buffer);
 
+    dec_thread_stop(ist);
     avcodec_free_context(&ist->dec_ctx);
     avcodec_parameters_free(&ist->par);
 
@@ -1088,7 +1293,9 @@ int ifile_open(const OptionsContext *o, const char *filename)
         f->rate_emu = 0;
     }
 
-    d->thread_queue_size = o->thread_queue_size;
+    d->thread_queue_size  = o->thread_queue_size;
+    d->eagain_backoff_min = FFMAX(o->eagain_backoff_min, 1);
+    d->eagain_backoff_max = FFMAX(o->eagain_backoff_max, d->eagain_backoff_min);
 
     /* update the current parameters so that they match the one of the input stream */
     add_input_streams(o, d);
@@ -27,6 +27,12 @@
  *
  * ffmpeg-kit changes by ARTHENICA LTD
  *
+ * 10.2026
+ * --------------------------------------------------------
+ * - filtergraphs can be driven by their own threads, see fg_thread_start()
+ * - time spent in av_buffersrc_add_frame_flags() on filtergraph threads measured for stream reports
+ * - filtergraph threads traced when -trace_file is set
+ *
  * 07.2023
  * --------------------------------------------------------
  * - FFmpeg 6.0 changes migrated
@@ -61,6 +67,8 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/samplefmt.h"
 
+extern __thread long globalSessionId;
+
 // FIXME: YUV420P etc. are actually supported with full color range,
 // yet the latter information isn't available here.
 static const enum AVPixelFormat *get_compliance_normal_pix_fmts(const AVCodec *codec, const enum AVPixelFormat default_formats[])
@@ -1099,9 +1107,185 @@ static int configure_input_filter(FilterGraph *fg, InputFilter *ifilter,
     }
 }
 
+/*
+ * Worker driving a filtergraph when filtergraph_parallel is set. The
+ * transcode thread hands it one frame at a time and it pushes the frame through
+ * the graph, so that independent graphs fed by the same decoder filter
+ * concurrently. Everything else touching the graph runs on the transcode
+ * thread after fg_thread_wait().
+ */
+struct FilterGraphThread {
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    long            session_id;
+    Tracer         *tracer;
+    int             index;
+
+    /* the fields below are protected by lock */
+    int             pending;
+    int             stop;
+    InputFilter    *ifilter;
+    AVFrame        *frame;
+    int             error;
+};
+
+static void *fg_thread_main(void *arg)
+{
+    FilterGraphThread *fgt = arg;
+
+    globalSessionId = fgt->session_id;
+    trace_thread_init(fgt->tracer, "filter %d", fgt->index);
+
+    pthread_mutex_lock(&fgt->lock);
+    while (1) {
+        StageTimer timer;
+        int64_t trace_start;
+        int ret;
+
+        while (!fgt->pending && !fgt->stop)
+            pthread_cond_wait(&fgt->cond, &fgt->lock);
+        if (!fgt->pending)
+            break;
+        pthread_mutex_unlock(&fgt->lock);
+
+        trace_start = trace_span_begin();
+        stage_timer_start(&timer);
+        ret = av_buffersrc_add_frame_flags(fgt->ifilter->filter, fgt->frame,
+                                           AV_BUFFERSRC_FLAG_PUSH);
+        if (fgt->ifilter->ist)
+            stage_timer_stop(&timer, &fgt->ifilter->ist->filter_time);
+        trace_span_end("filter", trace_start);
+        av_frame_unref(fgt->frame);
+
+        pthread_mutex_lock(&fgt->lock);
+        if (ret < 0 && ret != AVERROR_EOF && !fgt->error)
+            fgt->error = ret;
+        fgt->pending = 0;
+        pthread_cond_signal(&fgt->cond);
+    }
+    pthread_mutex_unlock(&fgt->lock);
+
+    trace_thread_uninit();
+
+    return NULL;
+}
+
+int fg_thread_start(FilterGraph *fg)
+{
+    FilterGraphThread *fgt;
+    int ret;
+
+    fgt = av_mallocz(sizeof(*fgt));
+    if (!fgt)
+        return AVERROR(ENOMEM);
+
+    fgt->session_id = globalSessionId;
+    fgt->tracer     = trace_session();
+    fgt->index      = fg->index;
+
+    fgt->frame = av_frame_alloc();
+    if (!fgt->frame) {
+        av_freep(&fgt);
+        return AVERROR(ENOMEM);
+    }
+
+    if ((ret = pthread_mutex_init(&fgt->lock, NULL))) {
+        av_frame_free(&fgt->frame);
+        av_freep(&fgt);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&fgt->cond, NULL))) {
+        pthread_mutex_destroy(&fgt->lock);
+        av_frame_free(&fgt->frame);
+        av_freep(&fgt);
+        return AVERROR(ret);
+    }
+
+    if ((ret = pthread_create(&fgt->thread, NULL, fg_thread_main, fgt))) {
+        av_log(NULL, AV_LOG_ERROR, "pthread_create failed: %s. Try to increase `ulimit -v` or decrease `ulimit -s`.\n", strerror(ret));
+        pthread_cond_destroy(&fgt->cond);
+        pthread_mutex_destroy(&fgt->lock);
+        av_frame_free(&fgt->frame);
+        av_freep(&fgt);
+        return AVERROR(ret);
+    }
+
+    fg->thread = fgt;
+
+    return 0;
+}
+
+void fg_thread_stop(FilterGraph *fg)
+{
+    FilterGraphThread *fgt = fg->thread;
+
+    if (!fgt)
+        return;
+
+    pthread_mutex_lock(&fgt->lock);
+    fgt->stop = 1;
+    pthread_cond_signal(&fgt->cond);
+    pthread_mutex_unlock(&fgt->lock);
+
+    pthread_join(fgt->thread, NULL);
+
+    pthread_cond_destroy(&fgt->cond);
+    pthread_mutex_destroy(&fgt->lock);
+    av_frame_free(&fgt->frame);
+
+    av_freep(&fg->thread);
+}
+
+int fg_thread_wait(FilterGraph *fg)
+{
+    FilterGraphThread *fgt = fg->thread;
+    int ret;
+
+    if (!fgt)
+        return 0;
+
+    pthread_mutex_lock(&fgt->lock);
+    while (fgt->pending)
+        pthread_cond_wait(&fgt->cond, &fgt->lock);
+    ret = fgt->error;
+    pthread_mutex_unlock(&fgt->lock);
+
+    return ret;
+}
+
+int fg_thread_send_frame(InputFilter *ifilter, AVFrame *frame, int keep_reference)
+{
+    FilterGraphThread *fgt = ifilter->graph->thread;
+    int ret;
+
+    if ((ret = fg_thread_wait(ifilter->graph)) < 0)
+        return ret;
+
+    /* the graphs share the frame data, only the reference is duplicated */
+    if (keep_reference) {
+        ret = av_frame_ref(fgt->frame, frame);
+        if (ret < 0)
+            return ret;
+    } else
+        av_frame_move_ref(fgt->frame, frame);
+
+    pthread_mutex_lock(&fgt->lock);
+    fgt->ifilter = ifilter;
+    fgt->pending = 1;
+    pthread_cond_signal(&fgt->cond);
+    pthread_mutex_unlock(&fgt->lock);
+
+    return 0;
+}
+
 static void cleanup_filtergraph(FilterGraph *fg)
 {
     int i;
+
+    /* a failed push is reported again by the next fg_thread_wait() */
+    fg_thread_wait(fg);
+
     for (i = 0; i < fg->nb_outputs; i++)
         fg->outputs[i]->filter = (AVFilterContext *)NULL;
     for (i = 0; i < fg->nb_inputs; i++)
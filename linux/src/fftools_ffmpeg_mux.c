@@ -25,6 +25,15 @@
  *
  * ffmpeg-kit changes by ARTHENICA LTD
  *
+ * 10.2026
+ * --------------------------------------------------------
+ * - encoder thread stopped before the output stream is freed
+ * - choose_output() heap updated when last_mux_dts changes
+ * - muxer queue takes its packets from the session packet pool
+ * - output size queried periodically in write_packet() unless -fs is used, see update_filesize()
+ * - time spent in av_interleaved_write_frame() measured for stream reports, of_queue_depth() added
+ * - muxer threads traced when -trace_file is set
+ *
  * 07.2023
  * --------------------------------------------------------
  * - FFmpeg 6.0 changes migrated
@@ -55,6 +64,7 @@
 #include "libavutil/intreadwrite.h"
 #include "libavutil/log.h"
 #include "libavutil/mem.h"
+#include "libavutil/time.h"
 #include "libavutil/timestamp.h"
 #include "libavutil/thread.h"
 
@@ -88,20 +98,46 @@ static int64_t filesize(AVIOContext *pb)
     return ret;
 }
 
+/* without -fs, the output size is queried at most once per this many microseconds */
+#define FILESIZE_QUERY_INTERVAL 500000
+
+/*
+ * Publish the output size after a packet of the given size was written. The
+ * size is queried from the AVIOContext only periodically, since that may cost a
+ * seek or an fstat() on some protocols, and advanced by the packet sizes in
+ * between.
+ */
+static void update_filesize(Muxer *mux, int64_t pkt_size)
+{
+    int64_t now = av_gettime_relative();
+
+    if (now - mux->filesize_query_time >= FILESIZE_QUERY_INTERVAL) {
+        mux->filesize_query_time = now;
+        atomic_store(&mux->last_filesize, filesize(mux->fc->pb));
+    } else if (mux->fc->pb && atomic_load(&mux->last_filesize) >= 0)
+        /* filesize() reports -1 for formats without a file or on errors, do not turn it into a size */
+        atomic_fetch_add(&mux->last_filesize, pkt_size);
+}
+
 static int write_packet(Muxer *mux, OutputStream *ost, AVPacket *pkt)
 {
     MuxStream *ms = ms_from_ost(ost);
     AVFormatContext *s = mux->fc;
     AVStream *st = ost->st;
-    int64_t fs;
+    StageTimer timer;
+    int64_t trace_start;
+    int64_t fs, pkt_size;
     uint64_t frame_num;
     int ret;
 
-    fs = filesize(s->pb);
-    atomic_store(&mux->last_filesize, fs);
-    if (fs >= mux->limit_filesize) {
-        ret = AVERROR_EOF;
-        goto fail;
+    /* the limit is enforced on the exact size */
+    if (mux->limit_filesize != INT64_MAX) {
+        fs = filesize(s->pb);
+        atomic_store(&mux->last_filesize, fs);
+        if (fs >= mux->limit_filesize) {
+            ret = AVERROR_EOF;
+            goto fail;
+        }
     }
 
     if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && ost->vsync_method == VSYNC_DROP)
@@ -177,12 +213,21 @@ static int write_packet(Muxer *mux, OutputStream *ost, AVPacket *pkt)
     if (ms->stats.io)
         enc_stats_write(ost, &ms->stats, NULL, pkt, frame_num);
 
+    pkt_size = pkt->size;
+
+    trace_start = trace_span_begin();
+    stage_timer_start(&timer);
     ret = av_interleaved_write_frame(s, pkt);
+    stage_timer_stop(&timer, &ost->mux_time);
+    trace_span_end("av_interleaved_write_frame", trace_start);
     if (ret < 0) {
         print_error("av_interleaved_write_frame()", ret);
         goto fail;
     }
 
+    if (mux->limit_filesize == INT64_MAX)
+        update_filesize(mux, pkt_size);
+
     return 0;
 fail:
     av_packet_unref(pkt);
@@ -239,10 +284,12 @@ static void *muxer_thread(void *arg)
     }
 
     thread_set_name(of);
+    trace_thread_init(mux->tracer, "mux %d", of->index);
 
     while (1) {
         OutputStream *ost;
         int stream_idx, stream_eof = 0;
+        int64_t trace_start;
 
         ret = tq_receive(mux->tq, &stream_idx, pkt);
         if (stream_idx < 0) {
@@ -252,7 +299,9 @@ static void *muxer_thread(void *arg)
         }
 
         ost = of->streams[stream_idx];
+        trace_start = trace_span_begin();
         ret = sync_queue_process(mux, ost, ret < 0 ? NULL : pkt, &stream_eof);
+        trace_span_end("sync_queue_process", trace_start);
         av_packet_unref(pkt);
         if (ret == AVERROR_EOF && stream_eof)
             tq_receive_finish(mux->tq, stream_idx);
@@ -270,6 +319,8 @@ finish:
 
     av_log(mux, AV_LOG_VERBOSE, "Terminating muxer thread\n");
 
+    trace_thread_uninit();
+
     return (void*)(intptr_t)ret;
 }
 
@@ -363,8 +414,10 @@ void of_output_packet(OutputFile *of, AVPacket *pkt, OutputStream *ost, int eof)
     const char *err_msg;
     int ret = 0;
 
-    if (!eof && pkt->dts != AV_NOPTS_VALUE)
+    if (!eof && pkt->dts != AV_NOPTS_VALUE) {
         ost->last_mux_dts = av_rescale_q(pkt->dts, pkt->time_base, AV_TIME_BASE_Q);
+        ost_heap_update(ost);
+    }
 
     /* apply the output bitstream filters */
     if (ms->bsf_ctx) {
@@ -437,7 +490,7 @@ static int thread_start(Muxer *mux)
     ObjPool *op;
     int ret;
 
-    op = objpool_alloc_packets();
+    op = objpool_session_packets();
     if (!op)
         return AVERROR(ENOMEM);
 
@@ -447,6 +500,8 @@ static int thread_start(Muxer *mux)
         return AVERROR(ENOMEM);
     }
 
+    mux->tracer = trace_session();
+
     ret = pthread_create(&mux->thread, NULL, muxer_thread, (void*)mux);
     if (ret) {
         tq_free(&mux->tq);
@@ -676,6 +731,8 @@ static void ost_free(OutputStream **post)
         return;
     ms = ms_from_ost(ost);
 
+    enc_thread_stop(ost);
+
     if (ost->logfile) {
         if (fclose(ost->logfile))
             av_log(ms, AV_LOG_ERROR,
@@ -779,3 +836,9 @@ int64_t of_filesize(OutputFile *of)
     Muxer *mux = mux_from_of(of);
     return atomic_load(&mux->last_filesize);
 }
+
+int of_queue_depth(OutputFile *of)
+{
+    Muxer *mux = mux_from_of(of);
+    return mux->tq ? tq_queued(mux->tq) : 0;
+}
@@ -26,6 +26,12 @@
  *
  * ffmpeg-kit changes by ARTHENICA LTD
  *
+ * 10.2026
+ * --------------------------------------------------------
+ * - filesize_query_time field added to Muxer
+ * - binary field added to EncStatsFile
+ * - tracer field added to Muxer
+ *
  * 07.2023
  * --------------------------------------------------------
  * - FFmpeg 6.0 changes migrated
@@ -138,6 +144,8 @@ typedef struct Muxer {
 
     pthread_t    thread;
     ThreadQueue *tq;
+    /* tracer of the session, captured for the muxer thread */
+    Tracer      *tracer;
 
     AVDictionary *opts;
 
@@ -146,6 +154,8 @@ typedef struct Muxer {
     /* filesize limit expressed in bytes */
     int64_t limit_filesize;
     atomic_int_least64_t last_filesize;
+    /* time of the last output size query, see update_filesize() */
+    int64_t filesize_query_time;
     int header_written;
 
     SyncQueue *sq_mux;
@@ -155,6 +165,7 @@ typedef struct Muxer {
 typedef struct EncStatsFile {
     char        *path;
     AVIOContext *io;
+    int          binary;
 } EncStatsFile;
 
 /* whether we want to print an SDP, set in of_open() */
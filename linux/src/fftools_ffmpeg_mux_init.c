@@ -26,6 +26,10 @@
  *
  * ffmpeg-kit changes by ARTHENICA LTD
  *
+ * 10.2026
+ * --------------------------------------------------------
+ * - stats files remember whether they were opened for -stats_binary records
+ *
  * 07.2023
  * --------------------------------------------------------
  * - FFmpeg 6.0 changes migrated
@@ -198,13 +202,18 @@ static int get_preset_file_2(const char *preset_name, const char *codec_name, AV
 __thread EncStatsFile   *enc_stats_files;
 __thread int nb_enc_stats_files;
 
-static int enc_stats_get_file(AVIOContext **io, const char *path)
+static int enc_stats_get_file(AVIOContext **io, const char *path, int binary)
 {
     EncStatsFile *esf;
     int ret;
 
     for (int i = 0; i < nb_enc_stats_files; i++)
         if (!strcmp(path, enc_stats_files[i].path)) {
+            if (enc_stats_files[i].binary != binary) {
+                av_log(NULL, AV_LOG_ERROR, "Stats file '%s' can not mix binary and text records\n",
+                       path);
+                return AVERROR(EINVAL);
+            }
             *io = enc_stats_files[i].io;
             return 0;
         }
@@ -223,6 +232,7 @@ static int enc_stats_get_file(AVIOContext **io, const char *path)
     esf->path = av_strdup(path);
     if (!esf->path)
         return AVERROR(ENOMEM);
+    esf->binary = binary;
 
     *io = esf->io;
 
@@ -279,7 +289,7 @@ static int unescape(char **pdst, size_t *dst_len,
 }
 
 static int enc_stats_init(OutputStream *ost, EncStats *es, int pre,
-                          const char *path, const char *fmt_spec)
+                          const char *path, const char *fmt_spec, int binary)
 {
     static const struct {
         enum EncStatsType  type;
@@ -394,9 +404,10 @@ fail:
             return ret;
     }
 
-    ret = enc_stats_get_file(&es->io, path);
+    ret = enc_stats_get_file(&es->io, path, binary);
     if (ret < 0)
         return ret;
+    es->binary = binary;
 
     return 0;
 }
@@ -533,7 +544,7 @@ static OutputStream *new_output_stream(Muxer *mux, const OptionsContext *o,
 
             MATCH_PER_STREAM_OPT(enc_stats_pre_fmt, str, format, oc, st);
 
-            ret = enc_stats_init(ost, &ost->enc_stats_pre, 1, enc_stats_pre, format);
+            ret = enc_stats_init(ost, &ost->enc_stats_pre, 1, enc_stats_pre, format, o->stats_binary);
             if (ret < 0)
                 exit_program(1);
         }
@@ -545,7 +556,7 @@ static OutputStream *new_output_stream(Muxer *mux, const OptionsContext *o,
 
             MATCH_PER_STREAM_OPT(enc_stats_post_fmt, str, format, oc, st);
 
-            ret = enc_stats_init(ost, &ost->enc_stats_post, 0, enc_stats_post, format);
+            ret = enc_stats_init(ost, &ost->enc_stats_post, 0, enc_stats_post, format, o->stats_binary);
             if (ret < 0)
                 exit_program(1);
         }
@@ -557,7 +568,7 @@ static OutputStream *new_output_stream(Muxer *mux, const OptionsContext *o,
 
             MATCH_PER_STREAM_OPT(mux_stats_fmt, str, format, oc, st);
 
-            ret = enc_stats_init(ost, &ms->stats, 0, mux_stats, format);
+            ret = enc_stats_init(ost, &ms->stats, 0, mux_stats, format, o->stats_binary);
             if (ret < 0)
                 exit_program(1);
         }
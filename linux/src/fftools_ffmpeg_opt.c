@@ -27,6 +27,12 @@
  *
  * ffmpeg-kit changes by ARTHENICA LTD
  *
+ * 10.2026
+ * --------------------------------------------------------
+ * - threaded_decoding, threaded_encoding and filtergraph_parallel option variables added
+ * - eagain_backoff_min and eagain_backoff_max defaults set in init_options()
+ * - trace_filename variable and opt_trace_file() added
+ *
  * 07.2023
  * --------------------------------------------------------
  * - FFmpeg 6.0 changes migrated
@@ -103,6 +109,7 @@ const char *const opt_name_top_field_first[]                  = {"top", NULL};
 __thread HWDevice *filter_hw_device;
 
 __thread char *vstats_filename;
+__thread char *trace_filename;
 __thread char *sdp_filename;
 
 __thread float audio_drift_threshold = 0.1;
@@ -129,6 +136,9 @@ __thread char *filter_nbthreads = NULL;
 __thread int filter_complex_nbthreads = 0;
 __thread int vstats_version = 2;
 __thread int auto_conversion_filters = 1;
+__thread int threaded_decoding = 1;
+__thread int threaded_encoding = 1;
+__thread int filtergraph_parallel = 0;
 __thread int64_t stats_period = 500000;
 
 
@@ -190,6 +200,8 @@ void init_options(OptionsContext *o)
     o->chapters_input_file = INT_MAX;
     o->accurate_seek  = 1;
     o->thread_queue_size = -1;
+    o->eagain_backoff_min = 100;
+    o->eagain_backoff_max = 10000;
     o->input_sync_ref = -1;
     o->find_stream_info = 1;
     o->shortest_buf_duration = 10.f;
@@ -951,6 +963,13 @@ int opt_vstats_file(void *optctx, const char *opt, const char *arg)
     return 0;
 }
 
+int opt_trace_file(void *optctx, const char *opt, const char *arg)
+{
+    av_free (trace_filename);
+    trace_filename = av_strdup (arg);
+    return trace_filename ? 0 : AVERROR(ENOMEM);
+}
+
 int opt_vstats(void *optctx, const char *opt, const char *arg)
 {
     char filename[40];
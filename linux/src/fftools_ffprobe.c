@@ -32,6 +32,10 @@
  *
  * ffmpeg-kit changes by ARTHENICA LTD
  *
+ * 10.2026
+ * --------------------------------------------------------
+ * - writer output can be redirected to an in-memory buffer using set_ffprobe_output_buffer
+ *
  * 07.2023
  * --------------------------------------------------------
  * - FFmpeg 6.0 changes migrated
@@ -312,6 +316,7 @@ __thread const char *output_filename = NULL;
 __thread struct AVHashContext *hash;
 
 __thread int main_ffprobe_return_code = 0;
+__thread AVBPrint *output_buffer = NULL;
 extern __thread int longjmp_value;
 
 static const struct {
@@ -644,6 +649,25 @@ static inline void writer_printf_printf(WriterContext *wctx, const char *fmt, ..
     va_end(ap);
 }
 
+static inline void writer_w8_bprint(WriterContext *wctx, int b)
+{
+    av_bprint_chars(output_buffer, b, 1);
+}
+
+static inline void writer_put_str_bprint(WriterContext *wctx, const char *str)
+{
+    av_bprint_append_data(output_buffer, str, strlen(str));
+}
+
+static inline void writer_printf_bprint(WriterContext *wctx, const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    av_vbprintf(output_buffer, fmt, ap);
+    va_end(ap);
+}
+
 static int writer_open(WriterContext **wctx, const Writer *writer, const char *args,
                        const struct section *sections, int nb_sections, const char *output)
 {
@@ -716,7 +740,11 @@ static int writer_open(WriterContext **wctx, const Writer *writer, const char *a
         }
     }
 
-    if (!output_filename) {
+    if (!output_filename && output_buffer) {
+        (*wctx)->writer_w8 = writer_w8_bprint;
+        (*wctx)->writer_put_str = writer_put_str_bprint;
+        (*wctx)->writer_printf = writer_printf_bprint;
+    } else if (!output_filename) {
         (*wctx)->writer_w8 = writer_w8_printf;
         (*wctx)->writer_put_str = writer_put_str_printf;
         (*wctx)->writer_printf = writer_printf_printf;
@@ -4093,6 +4121,16 @@ void ffprobe_var_cleanup() {
     }
 }
 
+/**
+ * Sets the buffer that receives writer output of ffprobe executions started on the calling
+ * thread. When it is NULL, writer output is forwarded to the log callback with AV_LOG_STDERR
+ * level.
+ */
+void set_ffprobe_output_buffer(AVBPrint *buffer)
+{
+    output_buffer = buffer;
+}
+
 int ffprobe_execute(int argc, char **argv)
 {
     char _program_name[] = "ffprobe";
@@ -24,12 +24,21 @@
  *
  * ffmpeg-kit changes by ARTHENICA LTD
  *
+ * 10.2026
+ * --------------------------------------------------------
+ * - pools made thread-safe, the free list is a lock-free stack of slots
+ * - pool capacity made configurable, slots are allocated as the pool grows
+ * - reference counted session pools added, see objpool_session_packets()
+ * - hit, miss and high-water mark statistics added
+ *
  * 07.2023
  * --------------------------------------------------------
  * - FFmpeg 6.0 changes migrated
  * - fftools header names updated
  */
 
+#include <inttypes.h>
+#include <stdatomic.h>
 #include <stdint.h>
 
 #include "libavcodec/packet.h"
@@ -37,73 +46,265 @@
 #include "libavutil/common.h"
 #include "libavutil/error.h"
 #include "libavutil/frame.h"
+#include "libavutil/log.h"
 #include "libavutil/mem.h"
+#include "libavutil/thread.h"
 
 #include "fftools_objpool.h"
 
-struct ObjPool {
-    void        *pool[32];
-    unsigned int pool_count;
+#define OBJPOOL_DEFAULT_CAPACITY 32
+#define OBJPOOL_SESSION_CAPACITY 256
+
+/* slots are allocated in chunks of this size as the pool grows */
+#define OBJPOOL_CHUNK_SIZE       32
+
+typedef struct ObjPoolSlot {
+    void        *obj;
+    /* index + 1 of the next slot in the same stack, 0 at the bottom */
+    atomic_uint  next;
+} ObjPoolSlot;
 
+/*
+ * Pooled objects are kept in slots. A slot is either on the full stack,
+ * holding an object, or on the empty stack. Both stacks are lock-free, their
+ * heads pack a generation counter in the upper 32 bits and the index + 1 of the
+ * top slot in the lower ones, so a head that was popped and pushed back in the
+ * meantime is not mistaken for an unchanged one.
+ */
+struct ObjPool {
     ObjPoolCBAlloc alloc;
     ObjPoolCBReset reset;
     ObjPoolCBFree  free;
+
+    unsigned int    capacity;
+    ObjPoolSlot   **chunks;
+    unsigned int    nb_chunks;
+    pthread_mutex_t grow_lock;
+
+    atomic_uint_least64_t full;
+    atomic_uint_least64_t empty;
+
+    atomic_int refcount;
+
+    atomic_uint_least64_t hits;
+    atomic_uint_least64_t misses;
+    atomic_uint_least64_t discards;
+    atomic_int            in_use;
+    atomic_int            in_use_max;
 };
 
-ObjPool *objpool_alloc(ObjPoolCBAlloc cb_alloc, ObjPoolCBReset cb_reset,
-                       ObjPoolCBFree cb_free)
+static ObjPoolSlot *slot_get(ObjPool *op, unsigned int idx)
+{
+    return &op->chunks[idx / OBJPOOL_CHUNK_SIZE][idx % OBJPOOL_CHUNK_SIZE];
+}
+
+static void stack_push(ObjPool *op, atomic_uint_least64_t *head, unsigned int idx)
+{
+    ObjPoolSlot *slot = slot_get(op, idx);
+    uint64_t old = atomic_load(head), new;
+
+    do {
+        atomic_store_explicit(&slot->next, (unsigned int)(old & UINT32_MAX),
+                              memory_order_relaxed);
+        new = (((old >> 32) + 1) << 32) | (idx + 1);
+    } while (!atomic_compare_exchange_weak(head, &old, new));
+}
+
+/* @return index of the popped slot, -1 when the stack is empty */
+static int stack_pop(ObjPool *op, atomic_uint_least64_t *head)
+{
+    uint64_t old = atomic_load(head), new;
+    unsigned int top;
+
+    do {
+        top = old & UINT32_MAX;
+        if (!top)
+            return -1;
+        new = (((old >> 32) + 1) << 32) | atomic_load(&slot_get(op, top - 1)->next);
+    } while (!atomic_compare_exchange_weak(head, &old, new));
+
+    return top - 1;
+}
+
+/* add a chunk of slots, one of which is returned instead of being pushed to the empty stack */
+static int pool_grow(ObjPool *op)
 {
-    ObjPool *op = av_mallocz(sizeof(*op));
+    ObjPoolSlot *chunk;
+    unsigned int first;
+    int idx = -1;
+
+    pthread_mutex_lock(&op->grow_lock);
+
+    /* another thread may have grown the pool meanwhile */
+    idx = stack_pop(op, &op->empty);
+    if (idx >= 0 || op->nb_chunks * OBJPOOL_CHUNK_SIZE >= op->capacity)
+        goto finish;
+
+    chunk = av_calloc(OBJPOOL_CHUNK_SIZE, sizeof(*chunk));
+    if (!chunk)
+        goto finish;
 
+    first = op->nb_chunks * OBJPOOL_CHUNK_SIZE;
+    op->chunks[op->nb_chunks++] = chunk;
+
+    for (unsigned int i = 1; i < OBJPOOL_CHUNK_SIZE && first + i < op->capacity; i++)
+        stack_push(op, &op->empty, first + i);
+    idx = first;
+
+finish:
+    pthread_mutex_unlock(&op->grow_lock);
+    return idx;
+}
+
+ObjPool *objpool_alloc2(ObjPoolCBAlloc cb_alloc, ObjPoolCBReset cb_reset,
+                        ObjPoolCBFree cb_free, unsigned int capacity)
+{
+    ObjPool *op;
+
+    if (!capacity || capacity > INT_MAX - OBJPOOL_CHUNK_SIZE)
+        return NULL;
+
+    op = av_mallocz(sizeof(*op));
     if (!op)
         return NULL;
 
-    op->alloc = cb_alloc;
-    op->reset = cb_reset;
-    op->free  = cb_free;
+    op->chunks = av_calloc((capacity + OBJPOOL_CHUNK_SIZE - 1) / OBJPOOL_CHUNK_SIZE,
+                           sizeof(*op->chunks));
+    if (!op->chunks) {
+        av_freep(&op);
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&op->grow_lock, NULL)) {
+        av_freep(&op->chunks);
+        av_freep(&op);
+        return NULL;
+    }
+
+    op->alloc    = cb_alloc;
+    op->reset    = cb_reset;
+    op->free     = cb_free;
+    op->capacity = capacity;
+
+    atomic_init(&op->full,       0);
+    atomic_init(&op->empty,      0);
+    atomic_init(&op->refcount,   1);
+    atomic_init(&op->hits,       0);
+    atomic_init(&op->misses,     0);
+    atomic_init(&op->discards,   0);
+    atomic_init(&op->in_use,     0);
+    atomic_init(&op->in_use_max, 0);
 
     return op;
 }
 
+ObjPool *objpool_alloc(ObjPoolCBAlloc cb_alloc, ObjPoolCBReset cb_reset,
+                       ObjPoolCBFree cb_free)
+{
+    return objpool_alloc2(cb_alloc, cb_reset, cb_free, OBJPOOL_DEFAULT_CAPACITY);
+}
+
+ObjPool *objpool_ref(ObjPool *op)
+{
+    atomic_fetch_add(&op->refcount, 1);
+    return op;
+}
+
 void objpool_free(ObjPool **pop)
 {
     ObjPool *op = *pop;
+    ObjPoolStats stats;
+    int idx;
 
     if (!op)
         return;
+    *pop = NULL;
+
+    if (atomic_fetch_sub(&op->refcount, 1) > 1)
+        return;
 
-    for (unsigned int i = 0; i < op->pool_count; i++)
-        op->free(&op->pool[i]);
+    objpool_get_stats(op, &stats);
+    if (stats.hits || stats.misses)
+        av_log(NULL, AV_LOG_DEBUG, "Object pool: %"PRIu64" hits, %"PRIu64" misses, "
+               "%"PRIu64" discarded, at most %u objects in use\n",
+               stats.hits, stats.misses, stats.discards, stats.in_use_max);
 
-    av_freep(pop);
+    while ((idx = stack_pop(op, &op->full)) >= 0)
+        op->free(&slot_get(op, idx)->obj);
+
+    for (unsigned int i = 0; i < op->nb_chunks; i++)
+        av_freep(&op->chunks[i]);
+    av_freep(&op->chunks);
+
+    pthread_mutex_destroy(&op->grow_lock);
+
+    av_freep(&op);
 }
 
 int  objpool_get(ObjPool *op, void **obj)
 {
-    if (op->pool_count) {
-        *obj = op->pool[--op->pool_count];
-        op->pool[op->pool_count] = NULL;
-    } else
+    int idx = stack_pop(op, &op->full);
+    int in_use, in_use_max;
+
+    if (idx >= 0) {
+        ObjPoolSlot *slot = slot_get(op, idx);
+
+        *obj      = slot->obj;
+        slot->obj = NULL;
+        stack_push(op, &op->empty, idx);
+
+        atomic_fetch_add_explicit(&op->hits, 1, memory_order_relaxed);
+    } else {
         *obj = op->alloc();
+        if (!*obj)
+            return AVERROR(ENOMEM);
+
+        atomic_fetch_add_explicit(&op->misses, 1, memory_order_relaxed);
+    }
 
-    return *obj ? 0 : AVERROR(ENOMEM);
+    in_use     = atomic_fetch_add_explicit(&op->in_use, 1, memory_order_relaxed) + 1;
+    in_use_max = atomic_load_explicit(&op->in_use_max, memory_order_relaxed);
+    while (in_use > in_use_max &&
+           !atomic_compare_exchange_weak_explicit(&op->in_use_max, &in_use_max, in_use,
+                                                  memory_order_relaxed, memory_order_relaxed));
+
+    return 0;
 }
 
 void objpool_release(ObjPool *op, void **obj)
 {
+    int idx;
+
     if (!*obj)
         return;
 
     op->reset(*obj);
 
-    if (op->pool_count < FF_ARRAY_ELEMS(op->pool))
-        op->pool[op->pool_count++] = *obj;
-    else
+    atomic_fetch_sub_explicit(&op->in_use, 1, memory_order_relaxed);
+
+    idx = stack_pop(op, &op->empty);
+    if (idx < 0)
+        idx = pool_grow(op);
+
+    if (idx >= 0) {
+        slot_get(op, idx)->obj = *obj;
+        stack_push(op, &op->full, idx);
+    } else {
         op->free(obj);
+        atomic_fetch_add_explicit(&op->discards, 1, memory_order_relaxed);
+    }
 
     *obj = NULL;
 }
 
+void objpool_get_stats(ObjPool *op, ObjPoolStats *stats)
+{
+    stats->hits       = atomic_load(&op->hits);
+    stats->misses     = atomic_load(&op->misses);
+    stats->discards   = atomic_load(&op->discards);
+    stats->in_use_max = atomic_load(&op->in_use_max);
+}
+
 static void *alloc_packet(void)
 {
     return av_packet_alloc();
@@ -143,3 +344,27 @@ ObjPool *objpool_alloc_frames(void)
 {
     return objpool_alloc(alloc_frame, reset_frame, free_frame);
 }
+
+/* pools of the session running on the calling thread, created on first use */
+static __thread ObjPool *session_packets = NULL;
+static __thread ObjPool *session_frames  = NULL;
+
+ObjPool *objpool_session_packets(void)
+{
+    if (!session_packets)
+        session_packets = objpool_alloc2(alloc_packet, reset_packet, free_packet,
+                                         OBJPOOL_SESSION_CAPACITY);
+    return session_packets ? objpool_ref(session_packets) : NULL;
+}
+ObjPool *objpool_session_frames(void)
+{
+    if (!session_frames)
+        session_frames = objpool_alloc2(alloc_frame, reset_frame, free_frame,
+                                        OBJPOOL_SESSION_CAPACITY);
+    return session_frames ? objpool_ref(session_frames) : NULL;
+}
+void objpool_session_uninit(void)
+{
+    objpool_free(&session_packets);
+    objpool_free(&session_frames);
+}
@@ -24,6 +24,10 @@
  *
  * ffmpeg-kit changes by ARTHENICA LTD
  *
+ * 10.2026
+ * --------------------------------------------------------
+ * - objpool_alloc2(), objpool_ref(), objpool_get_stats() and session pools added
+ *
  * 07.2023
  * --------------------------------------------------------
  * - FFmpeg 6.0 changes migrated
@@ -32,19 +36,53 @@
 #ifndef FFTOOLS_OBJPOOL_H
 #define FFTOOLS_OBJPOOL_H
 
+#include <stdint.h>
+
 typedef struct ObjPool ObjPool;
 
 typedef void* (*ObjPoolCBAlloc)(void);
 typedef void  (*ObjPoolCBReset)(void *);
 typedef void  (*ObjPoolCBFree)(void **);
 
+typedef struct ObjPoolStats {
+    /* objects handed out from the pool */
+    uint64_t     hits;
+    /* objects allocated because the pool was empty */
+    uint64_t     misses;
+    /* objects freed on release because the pool was full */
+    uint64_t     discards;
+    /* highest number of objects taken and not released yet */
+    unsigned int in_use_max;
+} ObjPoolStats;
+
+/*
+ * Pools are thread-safe: objects may be taken on one thread and released on
+ * another. A pool keeps at most capacity released objects, 32 for pools
+ * created with objpool_alloc(). objpool_free() drops a reference, the pool
+ * and the objects it keeps are freed with the last one.
+ */
 void     objpool_free(ObjPool **op);
 ObjPool *objpool_alloc(ObjPoolCBAlloc cb_alloc, ObjPoolCBReset cb_reset,
                        ObjPoolCBFree cb_free);
+ObjPool *objpool_alloc2(ObjPoolCBAlloc cb_alloc, ObjPoolCBReset cb_reset,
+                        ObjPoolCBFree cb_free, unsigned int capacity);
 ObjPool *objpool_alloc_packets(void);
 ObjPool *objpool_alloc_frames(void);
+ObjPool *objpool_ref(ObjPool *op);
+
+/*
+ * Packet and frame pools shared by all queues of the session running on the
+ * calling thread, so that objects are recycled across the whole pipeline.
+ * Each call returns a new reference. objpool_session_uninit() drops the
+ * reference held by the session.
+ */
+ObjPool *objpool_session_packets(void);
+ObjPool *objpool_session_frames(void);
+void     objpool_session_uninit(void);
 
 int  objpool_get(ObjPool *op, void **obj);
 void objpool_release(ObjPool *op, void **obj);
 
+void objpool_get_stats(ObjPool *op, ObjPoolStats *stats);
+
 #endif // FFTOOLS_OBJPOOL_H
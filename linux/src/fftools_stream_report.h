@@ -0,0 +1,79 @@
+/*
+ * This file is part of FFmpeg.
+ * Copyright (c) 2026 ARTHENICA LTD
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * This file does not exist in ffmpeg source code. It declares the per stream
+ * report that fftools_ffmpeg.c forwards to ffmpeg-kit, it is kept free of
+ * fftools internals so it can be included from C++.
+ *
+ * ffmpeg-kit changes by ARTHENICA LTD
+ *
+ * 10.2026
+ * --------------------------------------------------------
+ * - StreamReport and set_stream_report_callback() added
+ */
+
+#ifndef FFTOOLS_STREAM_REPORT_H
+#define FFTOOLS_STREAM_REPORT_H
+
+#include <stdint.h>
+
+#include "libavutil/avutil.h"
+
+/*
+ * Counters and stage times of one input or output stream, passed to the
+ * stream report callback with every progress report. Times are in
+ * microseconds, fields that do not apply to the stream are zero.
+ */
+typedef struct StreamReport {
+    int      file_index;
+    int      index;
+    int      output;            /* 1 for output streams, 0 for input streams */
+    enum AVMediaType type;
+
+    uint64_t packets_demuxed;
+    uint64_t frames_decoded;
+    uint64_t frames_filtered;   /* frames sent to (input) or received from (output) the filters */
+    uint64_t frames_encoded;
+    uint64_t packets_encoded;
+    uint64_t packets_muxed;
+    int64_t  frames_dup;
+    int64_t  frames_drop;
+
+    /* packets waiting in the demuxer (input) or muxer (output) thread queue of the file */
+    int      queue_depth;
+
+    int64_t  decode_wall_time;
+    int64_t  decode_cpu_time;
+    int64_t  filter_wall_time;
+    int64_t  filter_cpu_time;
+    int64_t  encode_wall_time;
+    int64_t  encode_cpu_time;
+    int64_t  mux_wall_time;
+    int64_t  mux_cpu_time;
+} StreamReport;
+
+/*
+ * Set the callback that receives a StreamReport for every input and output
+ * stream with each progress report. Stage times are measured while a callback
+ * is set.
+ */
+void set_stream_report_callback(void (*callback)(const StreamReport *reports, int nb_reports));
+
+#endif /* FFTOOLS_STREAM_REPORT_H */
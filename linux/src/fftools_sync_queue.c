@@ -24,6 +24,10 @@
  *
  * ffmpeg-kit changes by ARTHENICA LTD
  *
+ * 10.2026
+ * --------------------------------------------------------
+ * - objects taken from the session pools
+ *
  * 07.2023
  * --------------------------------------------------------
  * - FFmpeg 6.0 changes migrated
@@ -429,8 +433,8 @@ SyncQueue *sq_alloc(enum SyncQueueType type, int64_t buf_size_us)
     sq->head_stream          = -1;
     sq->head_finished_stream = -1;
 
-    sq->pool = (type == SYNC_QUEUE_PACKETS) ? objpool_alloc_packets() :
-                                              objpool_alloc_frames();
+    sq->pool = (type == SYNC_QUEUE_PACKETS) ? objpool_session_packets() :
+                                              objpool_session_frames();
     if (!sq->pool) {
         av_freep(&sq);
         return NULL;
@@ -24,18 +24,24 @@
  *
  * ffmpeg-kit changes by ARTHENICA LTD
  *
+ * 10.2026
+ * --------------------------------------------------------
+ * - lock-free single-producer/single-consumer ring replaces the locked FIFO,
+ *   threads only take the lock to sleep on a full or empty queue
+ * - tq_queued() added
+ *
  * 07.2023
  * --------------------------------------------------------
  * - FFmpeg 6.0 changes migrated
  * - fftools header names updated
  */
 
+#include <stdatomic.h>
 #include <stdint.h>
 #include <string.h>
 
 #include "libavutil/avassert.h"
 #include "libavutil/error.h"
-#include "libavutil/fifo.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/mem.h"
 #include "libavutil/thread.h"
@@ -53,17 +59,33 @@ typedef struct FifoElem {
     unsigned int stream_idx;
 } FifoElem;
 
+/*
+ * Items are passed through a ring written only by the sending thread and read
+ * only by the receiving one. head and tail count the items read and written so
+ * far; a slot is published by advancing tail and handed back by advancing head.
+ *
+ * The lock and the condition variables are only used to sleep while the ring
+ * is full or empty and to change the finished state. A thread about to sleep
+ * raises its waiting flag before checking the ring again under the lock, and
+ * the other side takes the lock to signal only when it sees the flag.
+ */
 struct ThreadQueue {
-    int              *finished;
+    atomic_int       *finished;
     unsigned int    nb_streams;
 
-    AVFifo  *fifo;
+    FifoElem        *ring;
+    size_t           ring_size;
+    atomic_size_t    head;
+    atomic_size_t    tail;
 
     ObjPool *obj_pool;
     void   (*obj_move)(void *dst, void *src);
 
     pthread_mutex_t lock;
-    pthread_cond_t  cond;
+    pthread_cond_t  cond_send;
+    pthread_cond_t  cond_recv;
+    atomic_int      send_waiting;
+    atomic_int      recv_waiting;
 };
 
 void tq_free(ThreadQueue **ptq)
@@ -73,18 +95,19 @@ void tq_free(ThreadQueue **ptq)
     if (!tq)
         return;
 
-    if (tq->fifo) {
-        FifoElem elem;
-        while (av_fifo_read(tq->fifo, &elem, 1) >= 0)
-            objpool_release(tq->obj_pool, &elem.obj);
+    if (tq->ring) {
+        size_t tail = atomic_load(&tq->tail);
+        for (size_t head = atomic_load(&tq->head); head != tail; head++)
+            objpool_release(tq->obj_pool, &tq->ring[head % tq->ring_size].obj);
     }
-    av_fifo_freep2(&tq->fifo);
+    av_freep(&tq->ring);
 
     objpool_free(&tq->obj_pool);
 
     av_freep(&tq->finished);
 
-    pthread_cond_destroy(&tq->cond);
+    pthread_cond_destroy(&tq->cond_recv);
+    pthread_cond_destroy(&tq->cond_send);
     pthread_mutex_destroy(&tq->lock);
 
     av_freep(ptq);
@@ -100,27 +123,43 @@ ThreadQueue *tq_alloc(unsigned int nb_streams, size_t queue_size,
     if (!tq)
         return NULL;
 
-    ret = pthread_cond_init(&tq->cond, NULL);
+    ret = pthread_cond_init(&tq->cond_send, NULL);
+    if (ret) {
+        av_freep(&tq);
+        return NULL;
+    }
+
+    ret = pthread_cond_init(&tq->cond_recv, NULL);
     if (ret) {
+        pthread_cond_destroy(&tq->cond_send);
         av_freep(&tq);
         return NULL;
     }
 
     ret = pthread_mutex_init(&tq->lock, NULL);
     if (ret) {
-        pthread_cond_destroy(&tq->cond);
+        pthread_cond_destroy(&tq->cond_recv);
+        pthread_cond_destroy(&tq->cond_send);
         av_freep(&tq);
         return NULL;
     }
 
+    atomic_init(&tq->head,         0);
+    atomic_init(&tq->tail,         0);
+    atomic_init(&tq->send_waiting, 0);
+    atomic_init(&tq->recv_waiting, 0);
+
     tq->finished = av_calloc(nb_streams, sizeof(*tq->finished));
     if (!tq->finished)
         goto fail;
+    for (unsigned int i = 0; i < nb_streams; i++)
+        atomic_init(&tq->finished[i], 0);
     tq->nb_streams = nb_streams;
 
-    tq->fifo = av_fifo_alloc2(queue_size, sizeof(FifoElem), 0);
-    if (!tq->fifo)
+    tq->ring = av_calloc(queue_size, sizeof(*tq->ring));
+    if (!tq->ring)
         goto fail;
+    tq->ring_size = queue_size;
 
     tq->obj_pool = obj_pool;
     tq->obj_move = obj_move;
@@ -131,67 +170,94 @@ fail:
     return NULL;
 }
 
+/* wake the other side up if it is sleeping, see struct ThreadQueue */
+static void wake(ThreadQueue *tq, atomic_int *waiting, pthread_cond_t *cond)
+{
+    if (!atomic_load(waiting))
+        return;
+
+    pthread_mutex_lock(&tq->lock);
+    pthread_cond_signal(cond);
+    pthread_mutex_unlock(&tq->lock);
+}
+
 int tq_send(ThreadQueue *tq, unsigned int stream_idx, void *data)
 {
-    int *finished;
+    atomic_int *finished;
+    FifoElem *elem;
+    size_t tail;
     int ret;
 
     av_assert0(stream_idx < tq->nb_streams);
     finished = &tq->finished[stream_idx];
 
-    pthread_mutex_lock(&tq->lock);
+    if (atomic_load(finished) & FINISHED_SEND)
+        return AVERROR(EINVAL);
 
-    if (*finished & FINISHED_SEND) {
-        ret = AVERROR(EINVAL);
-        goto finish;
-    }
+    tail = atomic_load_explicit(&tq->tail, memory_order_relaxed);
 
-    while (!(*finished & FINISHED_RECV) && !av_fifo_can_write(tq->fifo))
-        pthread_cond_wait(&tq->cond, &tq->lock);
+    if (tail - atomic_load(&tq->head) >= tq->ring_size &&
+        !(atomic_load(finished) & FINISHED_RECV)) {
+        pthread_mutex_lock(&tq->lock);
+        atomic_store(&tq->send_waiting, 1);
+        while (tail - atomic_load(&tq->head) >= tq->ring_size &&
+               !(atomic_load(finished) & FINISHED_RECV))
+            pthread_cond_wait(&tq->cond_send, &tq->lock);
+        atomic_store(&tq->send_waiting, 0);
+        pthread_mutex_unlock(&tq->lock);
+    }
 
-    if (*finished & FINISHED_RECV) {
-        ret = AVERROR_EOF;
-        *finished |= FINISHED_SEND;
-    } else {
-        FifoElem elem = { .stream_idx = stream_idx };
+    if (atomic_load(finished) & FINISHED_RECV) {
+        atomic_fetch_or(finished, FINISHED_SEND);
+        return AVERROR_EOF;
+    }
 
-        ret = objpool_get(tq->obj_pool, &elem.obj);
-        if (ret < 0)
-            goto finish;
+    elem = &tq->ring[tail % tq->ring_size];
 
-        tq->obj_move(elem.obj, data);
+    ret = objpool_get(tq->obj_pool, &elem->obj);
+    if (ret < 0)
+        return ret;
 
-        ret = av_fifo_write(tq->fifo, &elem, 1);
-        av_assert0(ret >= 0);
-        pthread_cond_broadcast(&tq->cond);
-    }
+    tq->obj_move(elem->obj, data);
+    elem->stream_idx = stream_idx;
 
-finish:
-    pthread_mutex_unlock(&tq->lock);
+    atomic_store(&tq->tail, tail + 1);
+    wake(tq, &tq->recv_waiting, &tq->cond_recv);
 
-    return ret;
+    return 0;
 }
 
-static int receive_locked(ThreadQueue *tq, int *stream_idx,
-                          void *data)
+static int receive_nonblock(ThreadQueue *tq, int *stream_idx,
+                            void *data)
 {
-    FifoElem elem;
+    size_t head = atomic_load_explicit(&tq->head, memory_order_relaxed);
     unsigned int nb_finished = 0;
 
-    if (av_fifo_read(tq->fifo, &elem, 1) >= 0) {
-        tq->obj_move(data, elem.obj);
-        objpool_release(tq->obj_pool, &elem.obj);
-        *stream_idx = elem.stream_idx;
+    if (head != atomic_load(&tq->tail)) {
+        FifoElem *elem = &tq->ring[head % tq->ring_size];
+
+        tq->obj_move(data, elem->obj);
+        objpool_release(tq->obj_pool, &elem->obj);
+        *stream_idx = elem->stream_idx;
+
+        atomic_store(&tq->head, head + 1);
+        wake(tq, &tq->send_waiting, &tq->cond_send);
         return 0;
     }
 
     for (unsigned int i = 0; i < tq->nb_streams; i++) {
-        if (!(tq->finished[i] & FINISHED_SEND))
+        int finished = atomic_load(&tq->finished[i]);
+
+        if (!(finished & FINISHED_SEND))
             continue;
 
+        /* items sent before the stream was finished must be returned first */
+        if (head != atomic_load(&tq->tail))
+            return receive_nonblock(tq, stream_idx, data);
+
         /* return EOF to the consumer at most once for each stream */
-        if (!(tq->finished[i] & FINISHED_RECV)) {
-            tq->finished[i] |= FINISHED_RECV;
+        if (!(finished & FINISHED_RECV)) {
+            atomic_fetch_or(&tq->finished[i], FINISHED_RECV);
             *stream_idx   = i;
             return AVERROR_EOF;
         }
@@ -202,29 +268,40 @@ static int receive_locked(ThreadQueue *tq, int *stream_idx,
     return nb_finished == tq->nb_streams ? AVERROR_EOF : AVERROR(EAGAIN);
 }
 
+/* true when tq_receive() would not sleep, called with the lock held */
+static int receive_ready(ThreadQueue *tq)
+{
+    if (atomic_load(&tq->head) != atomic_load(&tq->tail))
+        return 1;
+
+    for (unsigned int i = 0; i < tq->nb_streams; i++) {
+        int finished = atomic_load(&tq->finished[i]);
+        if ((finished & FINISHED_SEND) && !(finished & FINISHED_RECV))
+            return 1;
+    }
+
+    return 0;
+}
+
 int tq_receive(ThreadQueue *tq, int *stream_idx, void *data)
 {
     int ret;
 
     *stream_idx = -1;
 
-    pthread_mutex_lock(&tq->lock);
-
     while (1) {
-        ret = receive_locked(tq, stream_idx, data);
-        if (ret == AVERROR(EAGAIN)) {
-            pthread_cond_wait(&tq->cond, &tq->lock);
-            continue;
-        }
-
-        break;
+        ret = receive_nonblock(tq, stream_idx, data);
+        if (ret != AVERROR(EAGAIN))
+            break;
+
+        pthread_mutex_lock(&tq->lock);
+        atomic_store(&tq->recv_waiting, 1);
+        while (!receive_ready(tq))
+            pthread_cond_wait(&tq->cond_recv, &tq->lock);
+        atomic_store(&tq->recv_waiting, 0);
+        pthread_mutex_unlock(&tq->lock);
     }
 
-    if (ret == 0)
-        pthread_cond_broadcast(&tq->cond);
-
-    pthread_mutex_unlock(&tq->lock);
-
     return ret;
 }
 
@@ -237,12 +314,20 @@ void tq_send_finish(ThreadQueue *tq, unsigned int stream_idx)
     /* mark the stream as send-finished;
      * next time the consumer thread tries to read this stream it will get
      * an EOF and recv-finished flag will be set */
-    tq->finished[stream_idx] |= FINISHED_SEND;
-    pthread_cond_broadcast(&tq->cond);
+    atomic_fetch_or(&tq->finished[stream_idx], FINISHED_SEND);
+    pthread_cond_broadcast(&tq->cond_recv);
+    pthread_cond_broadcast(&tq->cond_send);
 
     pthread_mutex_unlock(&tq->lock);
 }
 
+size_t tq_queued(ThreadQueue *tq)
+{
+    size_t head = atomic_load(&tq->head);
+
+    return atomic_load(&tq->tail) - head;
+}
+
 void tq_receive_finish(ThreadQueue *tq, unsigned int stream_idx)
 {
     av_assert0(stream_idx < tq->nb_streams);
@@ -252,8 +337,9 @@ void tq_receive_finish(ThreadQueue *tq, unsigned int stream_idx)
     /* mark the stream as recv-finished;
      * next time the producer thread tries to send for this stream, it will
      * get an EOF and send-finished flag will be set */
-    tq->finished[stream_idx] |= FINISHED_RECV;
-    pthread_cond_broadcast(&tq->cond);
+    atomic_fetch_or(&tq->finished[stream_idx], FINISHED_RECV);
+    pthread_cond_broadcast(&tq->cond_recv);
+    pthread_cond_broadcast(&tq->cond_send);
 
     pthread_mutex_unlock(&tq->lock);
 }
@@ -24,6 +24,11 @@
  *
  * ffmpeg-kit changes by ARTHENICA LTD
  *
+ * 10.2026
+ * --------------------------------------------------------
+ * - single sender and single receiver requirement documented
+ * - tq_queued() added
+ *
  * 07.2023
  * --------------------------------------------------------
  * - FFmpeg 6.0 changes migrated
@@ -41,6 +46,9 @@ typedef struct ThreadQueue ThreadQueue;
 /**
  * Allocate a queue for sending data between threads.
  *
+ * Items are sent by one thread and received by one thread at a time, the
+ * finish functions may be called from either side.
+ *
  * @param nb_streams number of streams for which a distinct EOF state is
  *                   maintained
  * @param queue_size number of items that can be stored in the queue without
@@ -91,4 +99,10 @@ int tq_receive(ThreadQueue *tq, int *stream_idx, void *data);
  */
 void tq_receive_finish(ThreadQueue *tq, unsigned int stream_idx);
 
+/**
+ * Number of items waiting in the queue. May be called from any thread, the
+ * result is only a snapshot.
+ */
+size_t tq_queued(ThreadQueue *tq);
+
 #endif // FFTOOLS_THREAD_QUEUE_H
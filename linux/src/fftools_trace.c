@@ -0,0 +1,264 @@
+/*
+ * This file is part of FFmpeg.
+ * Copyright (c) 2026 ARTHENICA LTD
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * This file does not exist in ffmpeg source code. It records timestamped
+ * spans of the ffmpeg threads and writes them as a Chrome trace.
+ *
+ * ffmpeg-kit changes by ARTHENICA LTD
+ *
+ * 10.2026
+ * --------------------------------------------------------
+ * - session tracer, per thread span buffers and Chrome trace writer added
+ */
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "libavformat/avio.h"
+
+#include "libavutil/error.h"
+#include "libavutil/log.h"
+#include "libavutil/mem.h"
+#include "libavutil/time.h"
+
+#include "fftools_trace.h"
+
+/* spans are stored in chunks of this size as a buffer grows */
+#define TRACE_CHUNK_SIZE 4096
+/* spans kept per thread, later spans are only counted */
+#define TRACE_MAX_SPANS  (1 << 20)
+
+typedef struct TraceSpan {
+    const char *name;
+    int64_t     start;
+    int64_t     end;
+} TraceSpan;
+
+typedef struct TraceChunk {
+    struct TraceChunk *next;
+    int                nb_spans;
+    TraceSpan          spans[TRACE_CHUNK_SIZE];
+} TraceChunk;
+
+struct TraceBuffer {
+    TraceBuffer *next;
+
+    int          tid;
+    char         name[64];
+
+    TraceChunk  *first;
+    TraceChunk  *last;
+    int          nb_spans;
+    uint64_t     dropped;
+};
+
+struct Tracer {
+    char        *path;
+    int64_t      start_time;
+
+    /* buffers of all threads, a lock-free stack that is only pushed to while
+     * the session runs and read after all threads have exited */
+    TraceBuffer * _Atomic buffers;
+    atomic_int   nb_threads;
+};
+
+__thread TraceBuffer *trace_buffer = NULL;
+
+/* tracer of the session running on the calling thread */
+static __thread Tracer *session_tracer = NULL;
+
+void trace_span_add(TraceBuffer *tb, const char *name, int64_t start, int64_t end)
+{
+    TraceChunk *c = tb->last;
+    TraceSpan *span;
+
+    if (tb->nb_spans >= TRACE_MAX_SPANS) {
+        tb->dropped++;
+        return;
+    }
+
+    if (!c || c->nb_spans == TRACE_CHUNK_SIZE) {
+        c = av_malloc(sizeof(*c));
+        if (!c) {
+            tb->dropped++;
+            return;
+        }
+        c->next     = NULL;
+        c->nb_spans = 0;
+
+        if (tb->last)
+            tb->last->next = c;
+        else
+            tb->first = c;
+        tb->last = c;
+    }
+
+    span = &c->spans[c->nb_spans++];
+    span->name  = name;
+    span->start = start;
+    span->end   = end;
+    tb->nb_spans++;
+}
+
+void trace_thread_init(Tracer *tracer, const char *fmt, ...)
+{
+    TraceBuffer *tb;
+    va_list vl;
+
+    if (!tracer)
+        return;
+
+    tb = av_mallocz(sizeof(*tb));
+    if (!tb)
+        return;
+
+    tb->tid = atomic_fetch_add(&tracer->nb_threads, 1) + 1;
+
+    va_start(vl, fmt);
+    vsnprintf(tb->name, sizeof(tb->name), fmt, vl);
+    va_end(vl);
+
+    tb->next = atomic_load_explicit(&tracer->buffers, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&tracer->buffers, &tb->next, tb,
+                                                  memory_order_release,
+                                                  memory_order_relaxed))
+        ;
+
+    trace_buffer = tb;
+}
+
+void trace_thread_uninit(void)
+{
+    trace_buffer = NULL;
+}
+
+Tracer *trace_session(void)
+{
+    return session_tracer;
+}
+
+int trace_session_init(const char *path)
+{
+    Tracer *tracer;
+
+    trace_session_uninit();
+
+    tracer = av_mallocz(sizeof(*tracer));
+    if (!tracer)
+        return AVERROR(ENOMEM);
+
+    tracer->path = av_strdup(path);
+    if (!tracer->path) {
+        av_freep(&tracer);
+        return AVERROR(ENOMEM);
+    }
+    tracer->start_time = av_gettime_relative();
+    atomic_init(&tracer->buffers, NULL);
+    atomic_init(&tracer->nb_threads, 0);
+
+    session_tracer = tracer;
+    trace_thread_init(tracer, "main");
+
+    return 0;
+}
+
+/*
+ * Thread names are generated by ffmpeg and span names are literals, none of
+ * them need escaping.
+ */
+static int trace_write(Tracer *tracer)
+{
+    AVIOContext *io;
+    const char *sep = "";
+    int ret;
+
+    ret = avio_open(&io, tracer->path, AVIO_FLAG_WRITE);
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Error opening trace file '%s': %s\n",
+               tracer->path, av_err2str(ret));
+        return ret;
+    }
+
+    avio_printf(io, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (TraceBuffer *tb = atomic_load(&tracer->buffers); tb; tb = tb->next) {
+        avio_printf(io, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                    "\"args\":{\"name\":\"%s\"}}", sep, tb->tid, tb->name);
+        sep = ",\n";
+
+        for (TraceChunk *c = tb->first; c; c = c->next) {
+            for (int i = 0; i < c->nb_spans; i++) {
+                const TraceSpan *span = &c->spans[i];
+
+                avio_printf(io, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                            "\"ts\":%"PRId64",\"dur\":%"PRId64"}",
+                            span->name, tb->tid, span->start - tracer->start_time,
+                            span->end - span->start);
+            }
+        }
+
+        if (tb->dropped)
+            av_log(NULL, AV_LOG_WARNING, "%"PRIu64" trace spans of thread %s dropped\n",
+                   tb->dropped, tb->name);
+    }
+
+    avio_printf(io, "\n]}\n");
+
+    ret = avio_closep(&io);
+    if (ret < 0)
+        av_log(NULL, AV_LOG_ERROR, "Error writing trace file '%s': %s\n",
+               tracer->path, av_err2str(ret));
+
+    return ret;
+}
+
+void trace_session_uninit(void)
+{
+    Tracer *tracer = session_tracer;
+    TraceBuffer *tb;
+
+    if (!tracer)
+        return;
+
+    trace_buffer   = NULL;
+    session_tracer = NULL;
+
+    trace_write(tracer);
+
+    tb = atomic_load(&tracer->buffers);
+    while (tb) {
+        TraceBuffer *next = tb->next;
+        TraceChunk *c = tb->first;
+
+        while (c) {
+            TraceChunk *next_chunk = c->next;
+            av_free(c);
+            c = next_chunk;
+        }
+        av_free(tb);
+        tb = next;
+    }
+
+    av_freep(&tracer->path);
+    av_free(tracer);
+}
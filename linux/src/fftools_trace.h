@@ -0,0 +1,93 @@
+/*
+ * This file is part of FFmpeg.
+ * Copyright (c) 2026 ARTHENICA LTD
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * This file does not exist in ffmpeg source code. It records timestamped
+ * spans of the ffmpeg threads and writes them as a Chrome trace.
+ *
+ * ffmpeg-kit changes by ARTHENICA LTD
+ *
+ * 10.2026
+ * --------------------------------------------------------
+ * - session tracer, per thread span buffers and Chrome trace writer added
+ */
+
+#ifndef FFTOOLS_TRACE_H
+#define FFTOOLS_TRACE_H
+
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/time.h"
+
+typedef struct Tracer Tracer;
+typedef struct TraceBuffer TraceBuffer;
+
+/*
+ * Span buffer of the calling thread, NULL unless the thread belongs to a
+ * traced session. Only the owning thread writes to it, no locking is needed.
+ */
+extern __thread TraceBuffer *trace_buffer;
+
+/*
+ * Start tracing the session running on the calling thread. The trace is
+ * written to path by trace_session_uninit().
+ */
+int trace_session_init(const char *path);
+/*
+ * Write the trace and free the tracer. All threads of the session must have
+ * exited, buffers of threads that are still running are lost.
+ */
+void trace_session_uninit(void);
+/*
+ * Tracer of the session running on the calling thread, NULL if the session
+ * is not traced. Captured when a thread is created and passed to
+ * trace_thread_init() on the new thread.
+ */
+Tracer *trace_session(void);
+
+/*
+ * Attach the calling thread to tracer, does nothing if tracer is NULL. The
+ * name identifies the thread in the trace.
+ */
+void trace_thread_init(Tracer *tracer, const char *fmt, ...) av_printf_format(2, 3);
+void trace_thread_uninit(void);
+
+void trace_span_add(TraceBuffer *tb, const char *name, int64_t start, int64_t end);
+
+/*
+ * Start a span on the calling thread. Costs a thread local load when tracing
+ * is disabled.
+ */
+static inline int64_t trace_span_begin(void)
+{
+    return trace_buffer ? av_gettime_relative() : INT64_MIN;
+}
+
+/*
+ * End a span started with trace_span_begin(). name must be a string literal,
+ * it is stored by reference.
+ */
+static inline void trace_span_end(const char *name, int64_t start)
+{
+    if (start != INT64_MIN && trace_buffer)
+        trace_span_add(trace_buffer, name, start, av_gettime_relative());
+}
+
+#endif /* FFTOOLS_TRACE_H */